@@ -0,0 +1,291 @@
+#include "bytecodeCache.h"
+#include "compiler.h"
+#include "../Objects/objects.h"
+#include "../files.h"
+#include "../Runtime/nativeRegistry.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace compileCore;
+using namespace object;
+using std::get;
+
+//layout of the cache file(all numbers are stored in the byte order of the machine that wrote the cache):
+//magic, version
+//source files: name, hash of contents, line starts
+//globals: names, natives come first
+//functions: name, arity, upvalue count, bytecode offset, constants offset
+//constants: tag followed by the payload of the constant
+//bytecode, lines, index of the top level function
+#define CACHE_MAGIC 0x43534C43
+
+enum class ConstantTag {
+	NUM,
+	BOOL,
+	NIL,
+	STRING,
+	FUNC,
+	CLOSURE
+};
+inline constexpr unsigned operator+ (ConstantTag const val) { return static_cast<byte>(val); }
+
+static string cachePath(string mainFilePath) {
+	std::filesystem::path p(mainFilePath);
+	return p.replace_extension(".cslc").string();
+}
+
+static string projectRoot(string mainFilePath) {
+	std::filesystem::path p(mainFilePath);
+	return p.parent_path().string() + "/";
+}
+
+#pragma region Writing
+template<typename T>
+static void write(std::ofstream& out, const T& val) {
+	out.write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+static void write(std::ofstream& out, const string& str) {
+	write(out, static_cast<uInt>(str.size()));
+	out.write(str.data(), str.size());
+}
+
+template<typename T>
+static void writeVector(std::ofstream& out, const vector<T>& vec) {
+	write(out, static_cast<uInt>(vec.size()));
+	out.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+}
+
+bool compileCore::writeBytecodeCache(string mainFilePath, Compiler* compiler) {
+	std::ofstream out(cachePath(mainFilePath), std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) return false;
+	Chunk& code = compiler->mainCodeBlock;
+
+	write(out, static_cast<uInt>(CACHE_MAGIC));
+	write(out, static_cast<uInt>(BYTECODE_CACHE_VERSION));
+
+	write(out, static_cast<uInt>(compiler->sourceFiles.size()));
+	for (File* file : compiler->sourceFiles) {
+		write(out, file->name);
+		write(out, hashSource(file->sourceFile));
+		writeVector(out, file->lines);
+	}
+
+	write(out, static_cast<uInt>(compiler->globals.size()));
+	for (Globalvar& var : compiler->globals) write(out, var.name);
+
+	//every function is written once, constants refer to functions by their index
+	vector<ObjFunc*> functions;
+	unordered_map<ObjFunc*, uInt> functionIndex;
+	auto addFunction = [&](ObjFunc* func) {
+		if (functionIndex.try_emplace(func, functions.size()).second) functions.push_back(func);
+	};
+	addFunction(compiler->mainBlockFunc);
+	for (Value& val : code.constants) {
+		if (val.isFunction()) addFunction(val.asFunction());
+		else if (val.isClosure()) addFunction(val.asClosure()->func);
+	}
+	write(out, static_cast<uInt>(functions.size()));
+	for (ObjFunc* func : functions) {
+		write(out, func->name);
+		write(out, func->arity);
+		write(out, func->upvalueCount);
+		write(out, func->bytecodeOffset);
+		write(out, func->constantsOffset);
+	}
+
+	write(out, static_cast<uInt>(code.constants.size()));
+	for (Value& val : code.constants) {
+		if (val.isNumber()) {
+			write(out, static_cast<byte>(+ConstantTag::NUM));
+			write(out, get<double>(val.value));
+		}
+		else if (val.isBool()) {
+			write(out, static_cast<byte>(+ConstantTag::BOOL));
+			write(out, get<bool>(val.value));
+		}
+		else if (val.isNil()) write(out, static_cast<byte>(+ConstantTag::NIL));
+		else if (val.isString()) {
+			write(out, static_cast<byte>(+ConstantTag::STRING));
+			write(out, val.asString()->str);
+		}
+		else if (val.isFunction()) {
+			write(out, static_cast<byte>(+ConstantTag::FUNC));
+			write(out, functionIndex[val.asFunction()]);
+		}
+		else if (val.isClosure()) {
+			//only closures that don't capture any upvalues end up in the constants
+			write(out, static_cast<byte>(+ConstantTag::CLOSURE));
+			write(out, functionIndex[val.asClosure()->func]);
+		}
+		else {
+			//the compiler never produces any other kind of constant, bail instead of writing a cache we can't load
+			out.close();
+			std::filesystem::remove(cachePath(mainFilePath));
+			return false;
+		}
+	}
+
+	writeVector(out, code.bytecode);
+	writeVector(out, code.lines);
+	write(out, functionIndex[compiler->mainBlockFunc]);
+	return out.good();
+}
+#pragma endregion
+
+#pragma region Loading
+//every size read from the cache is checked against the bytes that are left in the file, so a truncated or corrupt
+//cache is rejected instead of making us allocate a garbage amount of memory
+struct CacheReader {
+	std::ifstream in;
+	uInt64 remaining = 0;
+
+	bool readBytes(char* dst, uInt64 size) {
+		if (size > remaining) return false;
+		in.read(dst, size);
+		remaining -= size;
+		return in.good();
+	}
+};
+
+template<typename T>
+static bool read(CacheReader& in, T& val) {
+	return in.readBytes(reinterpret_cast<char*>(&val), sizeof(T));
+}
+
+static bool read(CacheReader& in, string& str) {
+	uInt size;
+	if (!read(in, size) || size > in.remaining) return false;
+	str.resize(size);
+	return in.readBytes(str.data(), size);
+}
+
+template<typename T>
+static bool readVector(CacheReader& in, vector<T>& vec) {
+	uInt size;
+	if (!read(in, size) || static_cast<uInt64>(size) * sizeof(T) > in.remaining) return false;
+	vec.resize(size);
+	return in.readBytes(reinterpret_cast<char*>(vec.data()), static_cast<uInt64>(size) * sizeof(T));
+}
+
+bool compileCore::loadBytecodeCache(string mainFilePath, CachedProgram& program) {
+	CacheReader in;
+	string path = cachePath(mainFilePath);
+	std::error_code ec;
+	in.remaining = std::filesystem::file_size(path, ec);
+	if (ec) return false;
+	in.in.open(path, std::ios::binary);
+	if (!in.in.is_open()) return false;
+	string root = projectRoot(mainFilePath);
+
+	uInt magic, version;
+	if (!read(in, magic) || magic != CACHE_MAGIC) return false;
+	if (!read(in, version) || version != BYTECODE_CACHE_VERSION) return false;
+
+	//files are checked first since this is the cheapest way to find out that the cache is stale
+	uInt fileCount;
+	if (!read(in, fileCount)) return false;
+	vector<File*> files;
+	auto fail = [&]() {
+		for (File* file : files) delete file;
+		return false;
+	};
+	for (uInt i = 0; i < fileCount; i++) {
+		string name;
+		uInt64 hash;
+		if (!read(in, name) || !read(in, hash)) return fail();
+		string fullPath = root + name;
+		if (!std::filesystem::exists(fullPath)) return fail();
+		auto mapping = std::make_unique<MappedFile>(fullPath);
+		if (hashSource(mapping->getView()) != hash) return fail();
+		File* file = new File(name, std::move(mapping));
+		files.push_back(file);
+		if (!readVector(in, file->lines)) return fail();
+	}
+
+	uInt globalCount;
+	if (!read(in, globalCount)) return fail();
+	vector<Globalvar> globals;
+	for (uInt i = 0; i < globalCount; i++) {
+		string name;
+		if (!read(in, name)) return fail();
+		globals.push_back(Globalvar(name, Value::nil()));
+	}
+	//the bytecode refers to natives by index, if the set of natives changed the cache is useless
+	const vector<runtime::NativeBinding>& natives = runtime::nativeBindings();
+	if (globals.size() < natives.size()) return fail();
+	for (uInt i = 0; i < natives.size(); i++) {
+		if (globals[i].name != natives[i].name) return fail();
+	}
+
+	//objects allocated from here on are owned by the gc, so they don't need to be freed if loading fails
+	uInt functionCount;
+	if (!read(in, functionCount)) return fail();
+	vector<ObjFunc*> functions;
+	for (uInt i = 0; i < functionCount; i++) {
+		ObjFunc* func = new ObjFunc();
+		if (!read(in, func->name) || !read(in, func->arity) || !read(in, func->upvalueCount)
+			|| !read(in, func->bytecodeOffset) || !read(in, func->constantsOffset)) return fail();
+		//closures in the constants allocate their upvalue array as soon as they're loaded
+		if (func->upvalueCount < 0 || func->upvalueCount > UPVAL_MAX) return fail();
+		functions.push_back(func);
+	}
+
+	Chunk code;
+	uInt constantCount;
+	if (!read(in, constantCount)) return fail();
+	for (uInt i = 0; i < constantCount; i++) {
+		byte tag;
+		if (!read(in, tag)) return fail();
+		switch (tag) {
+		case +ConstantTag::NUM: {
+			double num;
+			if (!read(in, num)) return fail();
+			code.constants.push_back(Value(num));
+			break;
+		}
+		case +ConstantTag::BOOL: {
+			bool val;
+			if (!read(in, val)) return fail();
+			code.constants.push_back(Value(val));
+			break;
+		}
+		case +ConstantTag::NIL:
+			code.constants.push_back(Value::nil());
+			break;
+		case +ConstantTag::STRING: {
+			string str;
+			if (!read(in, str)) return fail();
+			code.constants.push_back(Value(new ObjString(str)));
+			break;
+		}
+		case +ConstantTag::FUNC:
+		case +ConstantTag::CLOSURE: {
+			uInt index;
+			if (!read(in, index) || index >= functions.size()) return fail();
+			if (tag == +ConstantTag::FUNC) code.constants.push_back(Value(functions[index]));
+			else code.constants.push_back(Value(new ObjClosure(functions[index])));
+			break;
+		}
+		default: return fail();
+		}
+	}
+
+	uInt mainIndex;
+	if (!readVector(in, code.bytecode) || !readVector(in, code.lines)) return fail();
+	if (!read(in, mainIndex) || mainIndex >= functions.size() || functions[mainIndex]->arity != 0) return fail();
+	//offsets are used without any checks at runtime
+	for (ObjFunc* func : functions) {
+		if (func->bytecodeOffset >= code.bytecode.size() || func->constantsOffset > code.constants.size()) return fail();
+	}
+	for (codeLine& line : code.lines) {
+		if (line.fileIndex >= files.size()) return fail();
+	}
+
+	program.globals = globals;
+	program.sourceFiles = files;
+	program.code = code;
+	program.mainBlockFunc = functions[mainIndex];
+	return true;
+}
+#pragma endregion
@@ -0,0 +1,27 @@
+#pragma once
+#include "codegenDefs.h"
+#include "../modulesDefs.h"
+
+namespace compileCore {
+	class Compiler;
+
+	//bump whenever the layout of the cache file, the instruction set or the calling convention changes
+	#define BYTECODE_CACHE_VERSION 4
+
+	//everything the VM needs to start executing a program, either taken from the compiler or loaded from a cache file
+	struct CachedProgram {
+		vector<Globalvar> globals;
+		vector<File*> sourceFiles;
+		Chunk code;
+		object::ObjFunc* mainBlockFunc = nullptr;
+	};
+
+	//the cache of a project lives next to it's main.csl, as main.cslc
+	//serializes the program produced by 'compiler', together with the hash of every source file that was compiled
+	//returns false if the file couldn't be written
+	bool writeBytecodeCache(string mainFilePath, Compiler* compiler);
+
+	//loads a previously compiled program, returns false if the cache doesn't exist, was written by a different version
+	//or if any of the source files it was compiled from changed
+	bool loadBytecodeCache(string mainFilePath, CachedProgram& program);
+}
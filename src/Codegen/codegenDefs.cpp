@@ -3,33 +3,34 @@
 #include "../Objects/objects.h"
 #include "../MemoryManagment/garbageCollector.h"
 #include "../DebugPrinting/BytecodePrinter.h"
-#include <format>
+#include "../Includes/fmt/format.h"
 #include <iostream>
+#include <algorithm>
 
 using namespace object;
 using std::get;
 
 Chunk::Chunk() {}
 
-void Chunk::writeData(uint8_t opCode, uInt line, byte fileIndex) {
+void Chunk::writeData(uint8_t opCode, uInt line, uInt column, byte fileIndex) {
 	bytecode.push_back(opCode);
 	if (lines.size() == 0) {
-		lines.push_back(codeLine(line, fileIndex));
+		lines.push_back(codeLine(line, column, fileIndex));
 		return;
 	}
-	if (lines[lines.size() - 1].line == line) return;
-	//if we're on a new line, mark the end of the bytecode for this line
-	//when looking up the line of code for a particular OP we check if it's position in 'code' is less than .end of a line
-	lines[lines.size() - 1].end = bytecode.size() - 1;
-	lines.push_back(codeLine(line, fileIndex));
+	codeLine& last = lines[lines.size() - 1];
+	if (last.line == line && last.column == column && last.fileIndex == fileIndex) return;
+	//if we're on a new position, mark the end of the bytecode for the previous run
+	//when looking up the line of code for a particular OP we search for the first run whose .end is greater than the OP position
+	last.end = bytecode.size() - 1;
+	lines.push_back(codeLine(line, column, fileIndex));
 }
 
 codeLine Chunk::getLine(uInt offset) {
-	for (int i = 0; i < lines.size(); i++) {
-		codeLine& line = lines[i];
-		if (offset < line.end) return line;
-	}
-	errorHandler::addSystemError(std::format("Couldn't show line for bytecode at position: {}", offset));
+	//runs are sorted by their end, so the first run that ends after offset is the one containing it
+	auto it = std::upper_bound(lines.begin(), lines.end(), offset, [](uInt offset, const codeLine& line) { return offset < line.end; });
+	if (it != lines.end()) return *it;
+	errorHandler::addSystemError(fmt::format("Couldn't show line for bytecode at position: {}", offset));
 	throw errorHandler::SystemException();
 }
 
@@ -41,16 +42,55 @@ void Chunk::disassemble(string name) {
 	}
 }
 
+//numbers are keyed by their bits, strings by their contents and other objects by their address
+static string constantKey(Value& val) {
+	string key;
+	switch (val.value.index()) {
+	case +ValueType::NUM: {
+		double num = get<double>(val.value);
+		//-0 and 0 are the same constant
+		if (num == 0) num = 0;
+		key.push_back('n');
+		key.append(reinterpret_cast<char*>(&num), sizeof(double));
+		break;
+	}
+	case +ValueType::BOOL:
+		key = get<bool>(val.value) ? "t" : "f";
+		break;
+	case +ValueType::OBJ: {
+		object::Obj* obj = get<object::Obj*>(val.value);
+		if (obj == nullptr) key = "z";
+		else if (obj->type == ObjType::STRING) key = "s" + val.asString()->str;
+		else {
+			key.push_back('o');
+			key.append(reinterpret_cast<char*>(&obj), sizeof(object::Obj*));
+		}
+		break;
+	}
+	}
+	return key;
+}
+
 //adds the constant to the array and returns it's index, which is used in conjuction with OP_CONSTANT
 //first checks if this value already exists, this helps keep the constants array small
 //returns index of the constant
 uInt Chunk::addConstant(Value val) {
-	for (uInt i = 0; i < constants.size(); i++) {
-		if (constants[i] == val) return i;
-	}
-	uInt size = constants.size();
+	auto it = constantIndex.try_emplace(constantKey(val), constants.size());
+	if (!it.second) return it.first->second;
 	constants.push_back(val);
-	return size;
+	return it.first->second;
+}
+
+string Chunk::getConstantsKey() {
+	string key;
+	for (Value& val : constants) {
+		string constant = constantKey(val);
+		//length prefix so that 2 different arrays can't produce the same key
+		uInt size = constant.size();
+		key.append(reinterpret_cast<char*>(&size), sizeof(uInt));
+		key.append(constant);
+	}
+	return key;
 }
 
 string valueToStr(Value& val) {
@@ -100,6 +140,12 @@ bool Value::isNativeFn() const {
 bool Value::isArray() const {
 	return isObj() && get<object::Obj*>(value)->type == ObjType::ARRAY;
 }
+bool Value::isTypedArray() const {
+	return isObj() && get<object::Obj*>(value)->type == ObjType::TYPED_ARRAY;
+}
+bool Value::isMap() const {
+	return isObj() && get<object::Obj*>(value)->type == ObjType::MAP;
+}
 bool Value::isClosure() const {
 	return isObj() && get<object::Obj*>(value)->type == ObjType::CLOSURE;
 }
@@ -118,12 +164,24 @@ bool Value::isUpvalue() const {
 bool Value::isFile() const {
 	return isObj() && get<object::Obj*>(value)->type == ObjType::FILE;
 }
+bool Value::isFileIterator() const {
+	return isObj() && get<object::Obj*>(value)->type == ObjType::FILE_ITERATOR;
+}
 bool Value::isMutex() const {
 	return isObj() && get<object::Obj*>(value)->type == ObjType::MUTEX;
 }
 bool Value::isFuture() const {
 	return isObj() && get<object::Obj*>(value)->type == ObjType::FUTURE;
 }
+bool Value::isChannel() const {
+	return isObj() && get<object::Obj*>(value)->type == ObjType::CHANNEL;
+}
+bool Value::isStringBuilder() const {
+	return isObj() && get<object::Obj*>(value)->type == ObjType::STRING_BUILDER;
+}
+bool Value::isStringSlice() const {
+	return isObj() && get<object::Obj*>(value)->type == ObjType::STRING_SLICE;
+}
 
 
 object::ObjString* Value::asString() {
@@ -138,6 +196,12 @@ object::ObjNativeFunc* Value::asNativeFn() {
 object::ObjArray* Value::asArray() {
 	return dynamic_cast<ObjArray*>(get<object::Obj*>(value));
 }
+object::ObjTypedArray* Value::asTypedArray() {
+	return dynamic_cast<ObjTypedArray*>(get<object::Obj*>(value));
+}
+object::ObjMap* Value::asMap() {
+	return dynamic_cast<ObjMap*>(get<object::Obj*>(value));
+}
 object::ObjClosure* Value::asClosure() {
 	return dynamic_cast<ObjClosure*>(get<object::Obj*>(value));
 }
@@ -156,12 +220,24 @@ object::ObjUpval* Value::asUpvalue() {
 object::ObjFile* Value::asFile() {
 	return dynamic_cast<ObjFile*>(get<object::Obj*>(value));
 }
+object::ObjFileIterator* Value::asFileIterator() {
+	return dynamic_cast<ObjFileIterator*>(get<object::Obj*>(value));
+}
 object::ObjMutex* Value::asMutex() {
 	return dynamic_cast<ObjMutex*>(get<object::Obj*>(value));
 }
 object::ObjFuture* Value::asFuture() {
 	return dynamic_cast<ObjFuture*>(get<object::Obj*>(value));
 }
+object::ObjChannel* Value::asChannel() {
+	return dynamic_cast<ObjChannel*>(get<object::Obj*>(value));
+}
+object::ObjStringBuilder* Value::asStringBuilder() {
+	return dynamic_cast<ObjStringBuilder*>(get<object::Obj*>(value));
+}
+object::ObjStringSlice* Value::asStringSlice() {
+	return dynamic_cast<ObjStringSlice*>(get<object::Obj*>(value));
+}
 
 void Value::mark() {
 	if (isObj()) memory::gc.markObj(get<object::Obj*>(value));
@@ -176,6 +252,8 @@ string Value::typeToStr() {
 		if (!temp) return "nil";
 		switch (temp->type) {
 		case object::ObjType::ARRAY: return "array";
+		case object::ObjType::TYPED_ARRAY: return "typed array";
+		case object::ObjType::MAP: return "map";
 		case object::ObjType::BOUND_METHOD: return "method";
 		case object::ObjType::CLASS: return "class " + asClass()->name;
 		case object::ObjType::CLOSURE: return "function";
@@ -183,7 +261,12 @@ string Value::typeToStr() {
 		case object::ObjType::INSTANCE: return asInstance()->klass == nullptr ? "struct" : "instance";
 		case object::ObjType::NATIVE: return "native function";
 		case object::ObjType::STRING: return "string";
+		case object::ObjType::STRING_BUILDER: return "string builder";
+		case object::ObjType::STRING_SLICE: return "string slice";
 		case object::ObjType::UPVALUE: return "upvalue";
+		case object::ObjType::FILE: return "file";
+		case object::ObjType::FILE_ITERATOR: return "file iterator";
+		case object::ObjType::CHANNEL: return "channel";
 		}
 	}
 	return "error, couldn't determine type of value";
@@ -7,8 +7,16 @@ namespace object {
 
 	class ObjString;
 
+	class ObjStringBuilder;
+
+	class ObjStringSlice;
+
 	class ObjArray;
 
+	class ObjTypedArray;
+
+	class ObjMap;
+
 	class ObjFunc;
 
 	class ObjNativeFunc;
@@ -25,9 +33,13 @@ namespace object {
 
 	class ObjFile;
 
+	class ObjFileIterator;
+
 	class ObjMutex;
 
 	class ObjFuture;
+
+	class ObjChannel;
 }
 
 enum class ValueType {
@@ -72,38 +84,57 @@ struct Value {
 	bool isNil() const { return std::holds_alternative<object::Obj*>(value) && get<object::Obj*>(value) == nullptr; };
 	bool isObj() const { return std::holds_alternative<object::Obj*>(value) && get<object::Obj*>(value) != nullptr; };
 
+	double asNumber() const { return get<double>(value); };
+	bool asBool() const { return get<bool>(value); };
+	object::Obj* asObj() const { return get<object::Obj*>(value); };
+
 	// Put everything in obj
 	bool isString() const;
 	bool isFunction() const;
 	bool isNativeFn() const;
 	bool isArray() const;
+	bool isTypedArray() const;
+	bool isMap() const;
 	bool isClosure() const;
 	bool isClass() const;
 	bool isInstance() const;
 	bool isBoundMethod() const;
 	bool isUpvalue() const;
 	bool isFile() const;
+	bool isFileIterator() const;
 	bool isMutex() const;
 	bool isFuture() const;
+	bool isChannel() const;
+	bool isStringBuilder() const;
+	bool isStringSlice() const;
 
 	object::ObjString* asString();
 	object::ObjFunc* asFunction();
 	object::ObjNativeFunc* asNativeFn();
 	object::ObjArray* asArray();
+	object::ObjTypedArray* asTypedArray();
+	object::ObjMap* asMap();
 	object::ObjClosure* asClosure();
 	object::ObjClass* asClass();
 	object::ObjInstance* asInstance();
 	object::ObjBoundMethod* asBoundMethod();
 	object::ObjUpval* asUpvalue();
 	object::ObjFile* asFile();
+	object::ObjFileIterator* asFileIterator();
 	object::ObjMutex* asMutex();
 	object::ObjFuture* asFuture();
+	object::ObjChannel* asChannel();
+	object::ObjStringBuilder* asStringBuilder();
+	object::ObjStringSlice* asStringSlice();
 
 	void mark();
 	string typeToStr();
 	#pragma endregion
 };
 
+//the string a value is printed as
+string valueToStr(Value& val);
+
 struct Globalvar {
 	string name;
 	Value val;
@@ -170,6 +201,7 @@ enum class OpCode {
 	SET_UPVALUE,//arg: 8-bit upval position
 	//Arrays
 	CREATE_ARRAY,//arg: 8-bit array size
+	CREATE_MAP,//arg: 8-bit number of key-value pairs
 	//get and set is used by both arrays and instances/structs, since struct.field is just syntax sugar for struct["field"] that
 	//gets optimized to use GET_PROPERTY
 	GET,
@@ -187,6 +219,7 @@ enum class OpCode {
 
 	//Functions
 	CALL,//arg: 8-bit argument count
+	TAIL_CALL,//arg: 8-bit argument count, always followed by RETURN
 	RETURN,
 	//TODO: MAKE SURE THAT CLOSURES CONVERT LOCALS TO UPVALUES
 	CLOSURE,//arg: 8-bit ObjFunction constant index
@@ -217,19 +250,25 @@ enum class OpCode {
 inline constexpr unsigned operator+ (OpCode const val) { return static_cast<byte>(val); }
 
 
+//a run of bytecode that was emitted for the same position in the source code
+//runs are stored sorted by 'end', which allows looking up the position of any instruction with a binary search
 struct codeLine {
+	//offset of the first byte after this run
 	uInt end;
 	uInt line;
+	uInt column;
 	//index of the file in the array of all source files held by the vm
 	byte fileIndex;
 
 	codeLine() {
 		line = 0;
+		column = 0;
 		end = 0;
 		fileIndex = 0;
 	}
-	codeLine(uInt _line, byte _fileIndex) {
+	codeLine(uInt _line, uInt _column, byte _fileIndex) {
 		line = _line;
+		column = _column;
 		end = 0;
 		fileIndex = _fileIndex;
 	}
@@ -244,11 +283,15 @@ public:
 	vector<codeLine> lines;
 	vector<uint8_t> bytecode;
 	vector<Value> constants;
+	//maps the key of every constant(see constantKey) to its index in 'constants', used to avoid duplicate constants
+	unordered_map<string, uInt> constantIndex;
 	Chunk();
-	void writeData(uint8_t opCode, uInt line, byte fileIndex);
+	void writeData(uint8_t opCode, uInt line, uInt column, byte fileIndex);
 	codeLine getLine(uInt offset);
 	void disassemble(string name);
 	uInt addConstant(Value val);
+	//key of the entire constants array, chunks with equal keys have interchangeable constants
+	string getConstantsKey();
 };
 
 #define FRAMES_MAX 256
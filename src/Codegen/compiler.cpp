@@ -1,9 +1,10 @@
 #include "compiler.h"
 #include "../MemoryManagment/garbageCollector.h"
 #include "../ErrorHandling/errorHandler.h"
+#include "../Runtime/nativeRegistry.h"
 #include <unordered_set>
 #include <iostream>
-#include <format>
+#include "../Includes/fmt/format.h"
 
 using namespace compileCore;
 using namespace object;
@@ -25,6 +26,7 @@ CurrentChunkInfo::CurrentChunkInfo(CurrentChunkInfo* _enclosing, FuncType _type)
 	localCount = 0;
 	scopeDepth = 0;
 	line = 0;
+	column = 0;
 	//first slot is claimed for function name
 	Local* local = &locals[localCount++];
 	local->depth = 0;
@@ -39,18 +41,22 @@ CurrentChunkInfo::CurrentChunkInfo(CurrentChunkInfo* _enclosing, FuncType _type)
 }
 
 
-Compiler::Compiler(vector<CSLModule*>& _units) {
+Compiler::Compiler(vector<CSLModule*>& _units, bool keepUnits) {
 	current = new CurrentChunkInfo(nullptr, FuncType::TYPE_SCRIPT);
 	currentClass = nullptr;
-	vector<File*> sourceFiles;
 	curUnitIndex = 0;
-	curGlobalIndex = 0;
 	units = _units;
+	buildSymbolTables();
 
+	//slots of natives are filled in by the VM
+	for (const runtime::NativeBinding& native : runtime::nativeBindings()) {
+		globals.push_back(Globalvar(native.name, Value::nil()));
+	}
 	for (CSLModule* unit : units) {
 		curUnit = unit;
+		curSymbols = &symbols[unit];
 		sourceFiles.push_back(unit->file);
-		for (Token token : unit->topDeclarations) {
+		for (const Token& token : unit->topDeclarations) {
 			globals.push_back(Globalvar(token.getLexeme(), Value::nil()));
 		}
 		for (int i = 0; i < unit->stmts.size(); i++) {
@@ -62,16 +68,22 @@ Compiler::Compiler(vector<CSLModule*>& _units) {
 				int a = 1;
 			}
 		}
-		curGlobalIndex += unit->topDeclarations.size();
 		curUnitIndex++;
 	}
-	std::cout << "=======global var array=======\n";
-	for (int i = 0; i < globals.size(); i++) {
-		std::cout << std::format("|{} {}| ", i, globals[i].name);
+	mainBlockFunc = endFuncDecl();
+	if (debugFlags::printGlobals) {
+		std::cout << "=======global var array=======\n";
+		for (int i = 0; i < globals.size(); i++) {
+			std::cout << fmt::format("|{} {}| ", i, globals[i].name);
+		}
+		std::cout << "\n";
 	}
-	std::cout << "\n";
 	memory::gc.collect(this);
-	for (CSLModule* unit : units) delete unit;
+	symbols.clear();
+	constantBlocks.clear();
+	if (!keepUnits) {
+		for (CSLModule* unit : units) delete unit;
+	}
 }
 
 
@@ -98,7 +110,7 @@ void Compiler::visitSetExpr(AST::SetExpr* expr) {
 		//the "." is always followed by a field name as a string, emitting a constant speeds things up and avoids unnecessary stack manipulation
 		expr->value->accept(this);
 		expr->callee->accept(this);
-		uInt16 name = identifierConstant(dynamic_cast<AST::LiteralExpr*>(expr->field.get())->token);
+		uInt16 name = identifierConstant(dynamic_cast<AST::LiteralExpr*>(expr->field)->token);
 		if (name <= SHORT_CONSTANT_LIMIT) emitBytes(+OpCode::SET_PROPERTY, name);
 		else emitByteAnd16Bit(+OpCode::SET_PROPERTY_LONG, name);
 		break;
@@ -183,7 +195,7 @@ void Compiler::visitUnaryExpr(AST::UnaryExpr* expr) {
 		if (expr->right->type == AST::ASTType::LITERAL) {
 			//if a variable is being incremented, first get what kind of variable it is(local, upvalue or global)
 			//also get argument(local: stack position, upvalue: upval position in func, global: name constant index)
-			AST::LiteralExpr* left = dynamic_cast<AST::LiteralExpr*>(expr->right.get());
+			AST::LiteralExpr* left = dynamic_cast<AST::LiteralExpr*>(expr->right);
 
 			updateLine(left->token);
 			arg = resolveLocal(left->token);
@@ -198,12 +210,12 @@ void Compiler::visitUnaryExpr(AST::UnaryExpr* expr) {
 		}
 		else if (expr->right->type == AST::ASTType::FIELD_ACCESS) {
 			//if a field is being incremented, compile the object, and then if it's not a dot access also compile the field
-			AST::FieldAccessExpr* left = dynamic_cast<AST::FieldAccessExpr*>(expr->right.get());
+			AST::FieldAccessExpr* left = dynamic_cast<AST::FieldAccessExpr*>(expr->right);
 			updateLine(left->accessor);
 			left->callee->accept(this);
 
 			if (left->accessor.type == TokenType::DOT) {
-				arg = identifierConstant(dynamic_cast<AST::LiteralExpr*>(left->field.get())->token);
+				arg = identifierConstant(dynamic_cast<AST::LiteralExpr*>(left->field)->token);
 				type = arg > SHORT_CONSTANT_LIMIT ? 5 : 4;
 			}
 			else {
@@ -246,10 +258,20 @@ void Compiler::visitArrayLiteralExpr(AST::ArrayLiteralExpr* expr) {
 	emitBytes(+OpCode::CREATE_ARRAY, expr->members.size());
 }
 
+void Compiler::visitMapLiteralExpr(AST::MapLiteralExpr* expr) {
+	updateLine(expr->bracket);
+	if (expr->entries.size() > UINT8_MAX) error(expr->bracket, "Map literals can't have more than 255 entries.");
+	//entries are pushed in order as key-value pairs, the VM inserts them in the same order so later duplicates win
+	for (AST::MapEntry& entry : expr->entries) {
+		entry.key->accept(this);
+		entry.val->accept(this);
+	}
+	emitBytes(+OpCode::CREATE_MAP, expr->entries.size());
+}
+
 void Compiler::visitCallExpr(AST::CallExpr* expr) {
 	//invoking is field access + call, when the compiler recognizes this pattern it optimizes
 	if (invoke(expr)) return;
-	//todo: tail recursion optimization
 	expr->callee->accept(this);
 	for (AST::ASTNodePtr arg : expr->args) {
 		arg->accept(this);
@@ -272,7 +294,7 @@ void Compiler::visitFieldAccessExpr(AST::FieldAccessExpr* expr) {
 	}
 								//object.property, we can optimize since we know the string in advance
 	case TokenType::DOT:
-		uInt16 name = identifierConstant(dynamic_cast<AST::LiteralExpr*>(expr->field.get())->token);
+		uInt16 name = identifierConstant(dynamic_cast<AST::LiteralExpr*>(expr->field)->token);
 		if (name <= SHORT_CONSTANT_LIMIT) emitBytes(+OpCode::GET_PROPERTY, name);
 		else emitByteAnd16Bit(+OpCode::GET_PROPERTY_LONG, name);
 		break;
@@ -507,7 +529,7 @@ void Compiler::visitClassDecl(AST::ClassDecl* decl) {
 		//if a class wants to inherit from a class in another file of the same name, the import has to use an alias, otherwise we get
 		//undefined behavior (eg. class a : a)
 		if (decl->inheritedClass->type == AST::ASTType::LITERAL) {
-			AST::LiteralExpr* expr = dynamic_cast<AST::LiteralExpr*>(decl->inheritedClass.get());
+			AST::LiteralExpr* expr = dynamic_cast<AST::LiteralExpr*>(decl->inheritedClass);
 			if (className.compare(expr->token)) {
 				error(expr->token, "A class can't inherit from itself.");
 			}
@@ -529,7 +551,7 @@ void Compiler::visitClassDecl(AST::ClassDecl* decl) {
 	}
 
 	for (AST::ASTNodePtr _method : decl->methods) {
-		method(dynamic_cast<AST::FuncDecl*>(_method.get()), className);
+		method(dynamic_cast<AST::FuncDecl*>(_method), className);
 	}
 	//pop the current class
 	emitByte(+OpCode::POP);
@@ -700,8 +722,8 @@ void Compiler::visitSwitchStmt(AST::SwitchStmt* stmt) {
 	vector<uInt16> constants;
 	vector<uInt16> jumps;
 	bool isLong = false;
-	for (std::shared_ptr<AST::CaseStmt> _case : stmt->cases) {
-		if (_case->caseType.getLexeme().compare("default") == 0) continue;
+	for (AST::CaseStmt* _case : stmt->cases) {
+		if (_case->caseType.getLexemeView() == "default") continue;
 		//a single case can contain multiple constants(eg. case 1 | 4 | 9:), each constant is compiled and its jump will point to the 
 		//same case code block
 		for (Token constant : _case->constants) {
@@ -769,8 +791,8 @@ void Compiler::visitSwitchStmt(AST::SwitchStmt* stmt) {
 
 	//compile the code of all cases, before each case update the jump for that case to the current ip
 	int i = 0;
-	for (std::shared_ptr<AST::CaseStmt> _case : stmt->cases) {
-		if (_case->caseType.getLexeme().compare("default") == 0) {
+	for (AST::CaseStmt* _case : stmt->cases) {
+		if (_case->caseType.getLexemeView() == "default") {
 			patchJump(jumps[jumps.size() - 1]);
 		}
 		else {
@@ -845,6 +867,20 @@ void Compiler::visitReturnStmt(AST::ReturnStmt* stmt) {
 		emitReturn();
 		return;
 	}
+	//'return f(...)' reuses the current call frame, invokes(field access and super calls) are compiled as regular calls
+	if (stmt->expr->type == AST::ASTType::CALL) {
+		AST::CallExpr* call = dynamic_cast<AST::CallExpr*>(stmt->expr);
+		if (call->callee->type != AST::ASTType::FIELD_ACCESS && call->callee->type != AST::ASTType::SUPER) {
+			call->callee->accept(this);
+			for (AST::ASTNodePtr arg : call->args) {
+				arg->accept(this);
+			}
+			emitBytes(+OpCode::TAIL_CALL, call->args.size());
+			//if the callee can't reuse the frame(eg. native functions) the VM does a regular call, and this RETURN returns its result
+			emitByte(+OpCode::RETURN);
+			return;
+		}
+	}
 	stmt->expr->accept(this);
 	emitByte(+OpCode::RETURN);
 }
@@ -855,7 +891,7 @@ void Compiler::visitReturnStmt(AST::ReturnStmt* stmt) {
 
 void Compiler::emitByte(byte byte) {
 	//line is incremented whenever we find a statement/expression that contains tokens
-	getChunk()->writeData(byte, current->line, sourceFiles.size() - 1);
+	getChunk()->writeData(byte, current->line, current->column, sourceFiles.size() - 1);
 }
 
 void Compiler::emitBytes(byte byte1, byte byte2) {
@@ -955,9 +991,11 @@ void Compiler::patchScopeJumps(ScopeJumpType type) {
 #pragma region Variables
 
 //creates a string constant from a token
-uInt16 Compiler::identifierConstant(Token name) {
+uInt16 Compiler::identifierConstant(const Token& name) {
 	updateLine(name);
 	string temp = name.getLexeme();
+	//object["field"] is compiled to a property access, the name of the field is the string without it's quotes
+	if (name.type == TokenType::STRING) temp = temp.substr(1, temp.size() - 2);
 	return makeConstant(Value(new ObjString(temp)));
 }
 
@@ -974,7 +1012,7 @@ void Compiler::defineVar(uInt16 name) {
 }
 
 //gets/sets a variable, respects the scoping rules(locals->upvalues->globals)
-void Compiler::namedVar(Token token, bool canAssign) {
+void Compiler::namedVar(const Token& token, bool canAssign) {
 	updateLine(token);
 	byte getOp;
 	byte setOp;
@@ -1005,25 +1043,19 @@ void Compiler::namedVar(Token token, bool canAssign) {
 
 //if 'name' is a global variable it's parsed and a string constant is returned
 //otherwise, if 'name' is a local variable it's passed to declareVar()
-uInt16 Compiler::parseVar(Token name) {
+uInt16 Compiler::parseVar(const Token& name) {
 	updateLine(name);
 	declareVar(name);
 	if (current->scopeDepth > 0) return 0;
-	//if this is a global variable, we tack on the index of this CSLModule at the start of the variable name(variable names can't start with numbers)
-	//used to differentiate variables of the same name from different souce files
-
-	//tacking on the current index since parseVar is only used for declaring a variable, which can only be done in the current source file
-	int index = curGlobalIndex;
-	for (Token token : curUnit->topDeclarations) {
-		if (name.compare(token)) return index;
-		index++;
-	}
+	//parseVar is only used for declaring a variable, which can only be done in the current source file
+	auto it = curSymbols->declarations.find(name.getLexemeView());
+	if (it != curSymbols->declarations.end()) return it->second;
 	error(name, "Couldn't find variable.");
 	return 0;
 }
 
 //makes sure the compiler is aware that a stack slot is occupied by this local variable
-void Compiler::declareVar(Token& name) {
+void Compiler::declareVar(const Token& name) {
 	updateLine(name);
 	//if we are currently in global scope, this has no use
 	if (current->scopeDepth == 0) return;
@@ -1032,8 +1064,7 @@ void Compiler::declareVar(Token& name) {
 		if (local->depth != -1 && local->depth < current->scopeDepth) {
 			break;
 		}
-		string str = name.getLexeme();
-		if (str.compare(local->name) == 0) {
+		if (name.getLexemeView() == local->name) {
 			error(name, "Already a variable with this name in this scope.");
 		}
 	}
@@ -1041,7 +1072,7 @@ void Compiler::declareVar(Token& name) {
 }
 
 //locals are stored on the stack, at compile time this is tracked with the 'locals' array
-void Compiler::addLocal(Token name) {
+void Compiler::addLocal(const Token& name) {
 	updateLine(name);
 	if (current->localCount == LOCAL_MAX) {
 		error(name, "Too many local variables in function.");
@@ -1073,13 +1104,12 @@ void Compiler::endScope() {
 	}
 }
 
-int Compiler::resolveLocal(CurrentChunkInfo* func, Token name) {
+int Compiler::resolveLocal(CurrentChunkInfo* func, const Token& name) {
 	//checks to see if there is a local variable with a provided name, if there is return the index of the stack slot of the var
 	updateLine(name);
 	for (int i = func->localCount - 1; i >= 0; i--) {
 		Local* local = &func->locals[i];
-		string str = name.getLexeme();
-		if (str.compare(local->name) == 0) {
+		if (name.getLexemeView() == local->name) {
 			if (local->depth == -1) {
 				error(name, "Can't read local variable in its own initializer.");
 			}
@@ -1090,11 +1120,11 @@ int Compiler::resolveLocal(CurrentChunkInfo* func, Token name) {
 	return -1;
 }
 
-int Compiler::resolveLocal(Token name) {
+int Compiler::resolveLocal(const Token& name) {
 	return resolveLocal(current, name);
 }
 
-int Compiler::resolveUpvalue(CurrentChunkInfo* func, Token name) {
+int Compiler::resolveUpvalue(CurrentChunkInfo* func, const Token& name) {
 	if (func->enclosing == nullptr) return -1;
 
 	int local = resolveLocal(func->enclosing, name);
@@ -1142,7 +1172,7 @@ Token Compiler::syntheticToken(string str) {
 #pragma endregion
 
 #pragma region Classes and methods
-void Compiler::method(AST::FuncDecl* _method, Token className) {
+void Compiler::method(AST::FuncDecl* _method, const Token& className) {
 	updateLine(_method->getName());
 	uInt16 name = identifierConstant(_method->getName());
 	//creating a new compilerInfo sets us up with a clean slate for writing bytecode, the enclosing functions info
@@ -1189,7 +1219,7 @@ void Compiler::method(AST::FuncDecl* _method, Token className) {
 bool Compiler::invoke(AST::CallExpr* expr) {
 	if (expr->callee->type == AST::ASTType::FIELD_ACCESS) {
 		//currently we only optimizes field invoking(struct.field() or array[field]())
-		AST::FieldAccessExpr* call = dynamic_cast<AST::FieldAccessExpr*>(expr->callee.get());
+		AST::FieldAccessExpr* call = dynamic_cast<AST::FieldAccessExpr*>(expr->callee);
 
 		call->callee->accept(this);
 
@@ -1203,7 +1233,7 @@ bool Compiler::invoke(AST::CallExpr* expr) {
 		return true;
 	}
 	else if (expr->callee->type == AST::ASTType::SUPER) {
-		AST::SuperExpr* superCall = dynamic_cast<AST::SuperExpr*>(expr->callee.get());
+		AST::SuperExpr* superCall = dynamic_cast<AST::SuperExpr*>(expr->callee);
 		uInt16 name = identifierConstant(superCall->methodName);
 
 		if (currentClass == nullptr) {
@@ -1239,7 +1269,7 @@ void Compiler::error(string message) {
 	throw CompilerException();
 }
 
-void Compiler::error(Token token, string msg) {
+void Compiler::error(const Token& token, string msg) {
 	errorHandler::addCompileError(msg, token);
 	throw CompilerException();
 }
@@ -1251,14 +1281,15 @@ ObjFunc* Compiler::endFuncDecl() {
 	Chunk& chunk = current->chunk;
 	// For the last line of code
 	chunk.lines[chunk.lines.size() - 1].end = chunk.bytecode.size();
-#ifdef COMPILER_DEBUG
-	chunk.disassemble(current->func->name.length() == 0 ? "script" : current->func->name);
-#endif
+	if (debugFlags::printBytecode) chunk.disassemble(current->func->name.length() == 0 ? "script" : current->func->name);
 	//Add the bytecode, lines and constants to the main code block
 	uInt64 bytecodeOffset = mainCodeBlock.bytecode.size();
 	mainCodeBlock.bytecode.insert(mainCodeBlock.bytecode.end(), chunk.bytecode.begin(), chunk.bytecode.end());
 	uInt64 constantsOffset = mainCodeBlock.constants.size();
-	mainCodeBlock.constants.insert(mainCodeBlock.constants.end(), chunk.constants.begin(), chunk.constants.end());
+	//functions with identical constants(common in generated code) share a single block of constants in the main code block
+	auto block = constantBlocks.try_emplace(chunk.getConstantsKey(), constantsOffset);
+	if (block.second) mainCodeBlock.constants.insert(mainCodeBlock.constants.end(), chunk.constants.begin(), chunk.constants.end());
+	else constantsOffset = block.first->second;
 	// Update lines to reflect the offset in the main code block
 	for (codeLine& line : chunk.lines) {
 		line.end += bytecodeOffset;
@@ -1275,95 +1306,75 @@ ObjFunc* Compiler::endFuncDecl() {
 }
 
 //a little helper for updating the lines emitted by the compiler(used for displaying runtime errors)
-void Compiler::updateLine(Token token) {
-	current->line = token.str.line;
-}
-
-//for every dependeny thats imported without an alias, check if any of its exports match 'symbol'
-uInt Compiler::checkSymbol(Token symbol) {
-	std::unordered_map<string, CSLModule*> importedSymbols;
-	string lexeme = symbol.getLexeme();
-	for (Dependency dep : curUnit->deps) {
-		if (dep.alias.type == TokenType::NONE) {
-			for (Token token : dep.module->exports) {
-
-				if (token.compare(symbol)) {
-					//if the correct symbol is found, find the index of the global variable inside of globals array
-					int globalIndex = 0;
-					for (int i = 0; i < units.size(); i++) {
-						if (units[i] != dep.module) {
-							globalIndex += units[i]->topDeclarations.size();
-							continue;
-						}
-						for (Token token : units[i]->topDeclarations) {
-							if (token.compare(symbol)) {
-								return globalIndex;
-							}
-							globalIndex++;
-						}
-					}
-					error(symbol, "Couldn't find source file of the definition.");
-				}
+void Compiler::updateLine(const Token& token) {
+	Span span = token.getSpan();
+	//synthetic tokens created by the compiler("this", "super") have no position, keep the position of the surrounding code
+	if (!span.sourceFile) return;
+	current->line = span.line;
+	current->column = span.column;
+}
+
+//builds symbol tables for every module, globals of all modules are stored in a single array in the order of 'units'
+//natives take up the start of the array and are visible in every module
+void Compiler::buildSymbolTables() {
+	const vector<runtime::NativeBinding>& natives = runtime::nativeBindings();
+	uInt globalIndex = natives.size();
+	for (CSLModule* unit : units) {
+		ModuleSymbols& table = symbols[unit];
+		for (Token& token : unit->topDeclarations) {
+			//if a symbol is declared twice the first declaration is used
+			table.declarations.try_emplace(token.getLexeme(), globalIndex);
+			globalIndex++;
+		}
+		for (Token& token : unit->exports) {
+			auto it = table.declarations.find(token.getLexeme());
+			if (it != table.declarations.end()) table.exports.try_emplace(it->first, it->second);
+		}
+	}
+	//exports of every module are known at this point, so imports can be resolved
+	for (CSLModule* unit : units) {
+		ModuleSymbols& table = symbols[unit];
+		for (Dependency& dep : unit->deps) {
+			if (dep.alias.type == TokenType::NONE) {
+				//ambiguous imports are reported by the parser
+				for (auto& [name, index] : symbols[dep.module].exports) table.imports.try_emplace(name, index);
 			}
+			else table.aliases.try_emplace(dep.alias.getLexeme(), dep.module);
 		}
+		//added last so that imported symbols shadow natives
+		for (uInt i = 0; i < natives.size(); i++) table.imports.try_emplace(natives[i].name, i);
 	}
+}
+
+//for every dependeny thats imported without an alias, check if any of its exports match 'symbol'
+uInt Compiler::checkSymbol(const Token& symbol) {
+	auto it = curSymbols->imports.find(symbol.getLexemeView());
+	if (it != curSymbols->imports.end()) return it->second;
 	error(symbol, "Variable not defined.");
 	return 0;
 }
 
-//finds the correct module from which a given top level variable originated, and appends the correct index as a prefix
-uInt Compiler::resolveGlobal(Token name, bool canAssign) {
-	bool inThisFile = false;
-	int index = curGlobalIndex;
-	for (Token token : curUnit->topDeclarations) {
-		if (name.getLexeme().compare(token.getLexeme()) == 0) {
-			inThisFile = true;
-			break;
-		}
-		index++;
-	}
-	if (canAssign) {
-		if (inThisFile) return index;
-	}
-	else {
-		if (inThisFile) return index;
-		else {
-			return checkSymbol(name);
-		}
-	}
+//finds the index of a top level variable in the globals array, imported variables can only be read
+uInt Compiler::resolveGlobal(const Token& name, bool canAssign) {
+	auto it = curSymbols->declarations.find(name.getLexemeView());
+	if (it != curSymbols->declarations.end()) return it->second;
+	if (!canAssign) return checkSymbol(name);
 	error(name, "Variable isn't declared.");
+	return 0;
 }
 
-//checks if 'variable' exists in a module which was imported with the alias 'moduleAlias', 
-//if it exists append that modules index to the variable
-uInt Compiler::resolveModuleVariable(Token moduleAlias, Token variable) {
-	//first find the module with the correct alias
-	Dependency* depPtr = nullptr;
-	for (Dependency dep : curUnit->deps) {
-		if (dep.alias.compare(moduleAlias)) {
-			depPtr = &dep;
-			break;
-		}
-	}
-	if (depPtr == nullptr) {
+//checks if 'variable' is exported by the module which was imported with the alias 'moduleAlias',
+//if it is, returns the index of 'variable' in the globals array
+uInt Compiler::resolveModuleVariable(const Token& moduleAlias, const Token& variable) {
+	auto aliasIt = curSymbols->aliases.find(moduleAlias.getLexemeView());
+	if (aliasIt == curSymbols->aliases.end()) {
 		error(moduleAlias, "Module alias doesn't exist.");
 	}
-
-	CSLModule* unit = depPtr->module;
-	int index = 0;
-	for (int i = 0; i < units.size(); i++) {
-		if (units[i] != unit) {
-			index += units[i]->topDeclarations.size();
-			continue;
-		}
-		//compare every export of said module against 'variable'
-		for (Token& token : unit->exports) {
-			if (token.compare(variable)) return index;
-			index++;
-		}
-	}
-
-	error(variable, std::format("Module {} doesn't export this symbol.", depPtr->alias.getLexeme()));
+	ModuleSymbols& table = symbols[aliasIt->second];
+	auto it = table.exports.find(variable.getLexemeView());
+	if (it != table.exports.end()) return it->second;
+	error(variable, fmt::format("Module {} doesn't export this symbol.", moduleAlias.getLexeme()));
+	return 0;
 }
 #pragma endregion
 
@@ -47,6 +47,7 @@ namespace compileCore {
 		bool hasReturnStmt;
 
 		uInt line;
+		uInt column;
 		//information about unpatched 'continue' and 'break' statements
 		vector<uInt> scopeJumps;
 		//locals
@@ -66,6 +67,18 @@ namespace compileCore {
 		ClassChunkInfo(ClassChunkInfo* _enclosing, bool _hasSuperclass) : enclosing(_enclosing), hasSuperclass(_hasSuperclass) {};
 	};
 
+	//symbol tables of a single module, built once before compilation so that resolving a global is a single lookup
+	struct ModuleSymbols {
+		//top level declarations of this module mapped to their index in the globals array
+		StringMap<uInt> declarations;
+		//subset of declarations which this module exports
+		StringMap<uInt> exports;
+		//symbols exported by dependencies which are imported without an alias
+		StringMap<uInt> imports;
+		//dependencies imported with an alias
+		StringMap<CSLModule*> aliases;
+	};
+
 	struct CompilerException {
 
 	};
@@ -80,8 +93,11 @@ namespace compileCore {
 		// Passed to the VM
 		vector<Globalvar> globals;
 		Chunk mainCodeBlock;
+		// Top level code of all modules, compiled as a single function
+		object::ObjFunc* mainBlockFunc;
 
-		Compiler(vector<CSLModule*>& units);
+		// Modules are deleted once compiled unless 'keepUnits' is set, in which case they stay owned by the caller
+		Compiler(vector<CSLModule*>& units, bool keepUnits = false);
 		Chunk* getChunk();
 		object::ObjFunc* endFuncDecl();
 
@@ -96,6 +112,7 @@ namespace compileCore {
 		void visitAsyncExpr(AST::AsyncExpr* expr);
 		void visitAwaitExpr(AST::AwaitExpr* expr);
 		void visitArrayLiteralExpr(AST::ArrayLiteralExpr* expr);
+		void visitMapLiteralExpr(AST::MapLiteralExpr* expr);
 		void visitStructLiteralExpr(AST::StructLiteral* expr);
 		void visitLiteralExpr(AST::LiteralExpr* expr);
 		void visitSuperExpr(AST::SuperExpr* expr);
@@ -122,9 +139,12 @@ namespace compileCore {
 		#pragma endregion 
 	private:
 		CSLModule* curUnit;
+		ModuleSymbols* curSymbols;
 		int curUnitIndex;
-		int curGlobalIndex;
 		vector<CSLModule*> units;
+		unordered_map<CSLModule*, ModuleSymbols> symbols;
+		//constants of already compiled functions(keyed by Chunk::getConstantsKey) mapped to their offset in mainCodeBlock
+		unordered_map<string, uInt64> constantBlocks;
 
 		#pragma region Helpers
 		//emitters
@@ -141,34 +161,35 @@ namespace compileCore {
 		void patchScopeJumps(ScopeJumpType type);
 		uInt16 makeConstant(Value value);
 		//variables
-		uInt16 identifierConstant(Token name);
+		uInt16 identifierConstant(const Token& name);
 		void defineVar(uInt16 name);
-		void namedVar(Token name, bool canAssign);
-		uInt16 parseVar(Token name);
+		void namedVar(const Token& name, bool canAssign);
+		uInt16 parseVar(const Token& name);
 		//locals
-		void declareVar(Token& name);
-		void addLocal(Token name);
-		int resolveLocal(Token name);
-		int resolveLocal(CurrentChunkInfo* func, Token name);
-		int resolveUpvalue(CurrentChunkInfo* func, Token name);
+		void declareVar(const Token& name);
+		void addLocal(const Token& name);
+		int resolveLocal(const Token& name);
+		int resolveLocal(CurrentChunkInfo* func, const Token& name);
+		int resolveUpvalue(CurrentChunkInfo* func, const Token& name);
 		int addUpvalue(byte index, bool isLocal);
 		void markInit();
 		void beginScope();
 		void endScope();
 		//classes and methods
-		void method(AST::FuncDecl* _method, Token className);
+		void method(AST::FuncDecl* _method, const Token& className);
 		bool invoke(AST::CallExpr* expr);
 		Token syntheticToken(string str);
 		//misc
-		void updateLine(Token token);
-		void error(Token token, string msg) throw(CompilerException);
-		void error(string message) throw(CompilerException);
+		void buildSymbolTables();
+		void updateLine(const Token& token);
+		void error(const Token& token, string msg);
+		void error(string message);
 		//checks all imports to see if the symbol 'token' is imported
-		uInt checkSymbol(Token token);
+		uInt checkSymbol(const Token& token);
 		//given a token and whether the operation is assigning or reading a variable, determines the correct symbol to use
-		uInt resolveGlobal(Token token, bool canAssign);
+		uInt resolveGlobal(const Token& token, bool canAssign);
 		//given a token for module alias and a token for variable name, returns correct symbol to use 
-		uInt resolveModuleVariable(Token moduleAlias, Token variable);
+		uInt resolveModuleVariable(const Token& moduleAlias, const Token& variable);
 		#pragma endregion
 	};
 }
\ No newline at end of file
@@ -44,7 +44,7 @@ void ASTPrinter::visitUnaryExpr(UnaryExpr* expr) {
 void ASTPrinter::visitCallExpr(CallExpr* expr) {
 	expr->callee->accept(this);
 	cout << "( ";
-	for (shared_ptr<ASTNode> node : expr->args) {
+	for (ASTNode* node : expr->args) {
 		node->accept(this);
 		cout << ", ";
 	}
@@ -75,13 +75,24 @@ void ASTPrinter::visitAwaitExpr(AwaitExpr* expr) {
 
 void ASTPrinter::visitArrayLiteralExpr(ArrayLiteralExpr* expr) {
 	cout << "[ ";
-	for (shared_ptr<ASTNode> node : expr->members) {
+	for (ASTNode* node : expr->members) {
 		node->accept(this);
 		cout << ", ";
 	}
 	cout << "]";
 }
 
+void ASTPrinter::visitMapLiteralExpr(MapLiteralExpr* expr) {
+	cout << "[ ";
+	for (MapEntry entry : expr->entries) {
+		entry.key->accept(this);
+		cout << " : ";
+		entry.val->accept(this);
+		cout << ", ";
+	}
+	cout << ":]";
+}
+
 void ASTPrinter::visitStructLiteralExpr(StructLiteral* expr) {
 	cout << "{ ";
 	for (StructEntry entry : expr->fields) {
@@ -149,7 +160,7 @@ void ASTPrinter::visitClassDecl(ClassDecl* decl) {
 		<< (decl->inherits ? ":" : "");
 	if(decl->inherits) decl->inheritedClass->accept(this);
 	cout << "{ " << endl;
-	for (shared_ptr<ASTNode> method : decl->methods) {
+	for (ASTNode* method : decl->methods) {
 		method->accept(this);
 	}
 	cout << "}" << endl;
@@ -171,7 +182,7 @@ void ASTPrinter::visitExprStmt(ExprStmt* stmt) {
 
 void ASTPrinter::visitBlockStmt(BlockStmt* stmt) {
 	cout << "{ " << endl;
-	for (shared_ptr<ASTNode> line : stmt->statements) {
+	for (ASTNode* line : stmt->statements) {
 		line->accept(this);
 	}
 	cout << "}" << endl;
@@ -224,7 +235,7 @@ void ASTPrinter::visitSwitchStmt(SwitchStmt* stmt) {
 	cout << "switch (";
 	stmt->expr->accept(this);
 	cout << ") {" << endl;
-	for (shared_ptr<CaseStmt> _case : stmt->cases) {
+	for (CaseStmt* _case : stmt->cases) {
 		_case->accept(this);
 	}
 	cout << "}" << endl;
@@ -236,7 +247,7 @@ void ASTPrinter::visitCaseStmt(CaseStmt* stmt) {
 		cout << token.getLexeme() << " | ";
 	}
 	cout << ": " << endl;
-	for (shared_ptr<ASTNode> statement : stmt->stmts) {
+	for (ASTNode* statement : stmt->stmts) {
 		statement->accept(this);
 	}
 }
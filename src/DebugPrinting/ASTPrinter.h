@@ -2,7 +2,7 @@
 #include "../Parsing/ASTDefs.h"
 
 namespace AST {
-	//used for debugging, controlled with AST_DEBUG in common.h
+	//used for debugging, controlled with debugFlags::printAST in common.h
 	class ASTPrinter : public Visitor {
 		void visitAssignmentExpr(AssignmentExpr* expr);
 		void visitSetExpr(SetExpr* expr);
@@ -14,6 +14,7 @@ namespace AST {
 		void visitAsyncExpr(AsyncExpr* expr);
 		void visitAwaitExpr(AwaitExpr* expr);
 		void visitArrayLiteralExpr(ArrayLiteralExpr* expr);
+		void visitMapLiteralExpr(MapLiteralExpr* expr);
 		void visitStructLiteralExpr(StructLiteral* expr);
 		void visitLiteralExpr(LiteralExpr* expr);
 		void visitFuncLiteral(FuncLiteral* expr);
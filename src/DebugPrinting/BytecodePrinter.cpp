@@ -1,5 +1,5 @@
 #include "BytecodePrinter.h"
-#include <format>
+#include "../Includes/fmt/format.h"
 #include "../Objects/objects.h"
 #include <iostream>
 
@@ -11,7 +11,7 @@ static int simpleInstruction(string name, int offset) {
 
 static int byteInstruction(string name, Chunk* chunk, int offset) {
 	uint8_t slot = chunk->bytecode[offset + 1];
-	std::cout << std::format("{:16} {:4d}", name, slot) << std::endl;
+	std::cout << fmt::format("{:16} {:4d}", name, slot) << std::endl;
 	return offset + 2;
 }
 
@@ -19,7 +19,7 @@ static int constantInstruction(string name, Chunk* chunk, int offset, bool isLon
 	uInt constant = 0;
 	if (!isLong) constant = chunk->bytecode[offset + 1];
 	else constant = ((chunk->bytecode[offset + 1] << 8) | chunk->bytecode[offset + 2]);
-	std::cout << std::format("{:16} {:4d} ", name, constant);
+	std::cout << fmt::format("{:16} {:4d} ", name, constant);
 	chunk->constants[constant].print();
 	std::cout<<"\n";
 	return offset + (isLong ? 3 : 2);
@@ -29,7 +29,7 @@ static int globalInstruction(string name, Chunk* chunk, int offset, bool isLong)
 	uInt constant = 0;
 	if (!isLong) constant = chunk->bytecode[offset + 1];
 	else constant = ((chunk->bytecode[offset + 1] << 8) | chunk->bytecode[offset + 2]);
-	std::cout << std::format("{:16} {:4d} \n", name, constant);
+	std::cout << fmt::format("{:16} {:4d} \n", name, constant);
 	return offset + (isLong ? 3 : 2);
 }
 
@@ -44,7 +44,7 @@ static int doubleConstantInstruction(string name, Chunk* chunk, int offset, bool
 		constant1 = ((chunk->bytecode[offset + 1] << 8) | chunk->bytecode[offset + 2]);
 		constant2 = ((chunk->bytecode[offset + 3] << 8) | chunk->bytecode[offset + 4]);
 	}
-	std::cout << std::format("{:16} {:4d} {:4d}", name, constant1, constant2);
+	std::cout << fmt::format("{:16} {:4d} {:4d}", name, constant1, constant2);
 	chunk->constants[constant1].print();
 	std::cout<<"' '";
 	chunk->constants[constant2].print();
@@ -55,14 +55,14 @@ static int doubleConstantInstruction(string name, Chunk* chunk, int offset, bool
 static int jumpInstruction(string name, int sign, Chunk* chunk, int offset) {
 	uint16_t jump = (uint16_t)(chunk->bytecode[offset + 1] << 8);
 	jump |= chunk->bytecode[offset + 2];
-	std::cout << std::format("{:16} {:4d} -> {:4d}", name, offset, offset + 3 + sign * jump) << std::endl;
+	std::cout << fmt::format("{:16} {:4d} -> {:4d}", name, offset, offset + 3 + sign * jump) << std::endl;
 	return offset + 3;
 }
 
 static int invokeInstruction(string name, Chunk* chunk, int offset) {
 	uint8_t constant = chunk->bytecode[offset + 1];
 	uint8_t argCount = chunk->bytecode[offset + 2];
-	std::cout << std::format("{:16} ({} args) {:4d} ", name, argCount, constant);
+	std::cout << fmt::format("{:16} ({} args) {:4d} ", name, argCount, constant);
 	chunk->constants[constant].print();
 	std::cout << "\n";
 	return offset + 3;
@@ -71,7 +71,7 @@ static int invokeInstruction(string name, Chunk* chunk, int offset) {
 static int longInvokeInstruction(string name, Chunk* chunk, int offset) {
 	uint8_t constant = (chunk->bytecode[offset + 1] | chunk->bytecode[offset + 2] | (chunk->bytecode[offset + 3] << 16));
 	uint8_t argCount = chunk->bytecode[offset + 4];
-	std::cout << std::format("{:16} ({} args) {:4d}", name, argCount, constant);
+	std::cout << fmt::format("{:16} ({} args) {:4d}", name, argCount, constant);
 	chunk->constants[constant].print();
 	std::cout << "'\n";
 	return offset + 5;
@@ -80,18 +80,18 @@ static int longInvokeInstruction(string name, Chunk* chunk, int offset) {
 static int incrementInstruction(string name, Chunk* chunk, int offset) {
 	uint8_t type = chunk->bytecode[offset + 1];
 	uint8_t arg = chunk->bytecode[offset + 2];
-	std::cout << std::format("{:16} {:4d} {:4d}", name, type, arg);
+	std::cout << fmt::format("{:16} {:4d} {:4d}", name, type, arg);
 	return offset + 3;
 }
 
 int disassembleInstruction(Chunk* chunk, int offset) {
-	std::cout << std::format("{:0>4d} ", offset);
+	std::cout << fmt::format("{:0>4d} ", offset);
 
 	if (offset > 0 && chunk->getLine(offset).line == chunk->getLine(offset - 1).line) {
 		std::cout << "   | ";
 	}
 	else {
-		std::cout << std::format("{:4d} ", chunk->getLine(offset).line);
+		std::cout << fmt::format("{:4d} ", chunk->getLine(offset).line);
 	}
 
 	uint8_t instruction = chunk->bytecode[offset];
@@ -124,25 +124,25 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 		byte type = (args >> 2);
 		switch (type) {
 		case 0: {
-			std::cout << std::format("OP INCREMENT {} {} local: {}", sign, fix, chunk->bytecode[offset++]) << std::endl; break;
+			std::cout << fmt::format("OP INCREMENT {} {} local: {}", sign, fix, chunk->bytecode[offset++]) << std::endl; break;
 		}
 		case 1: {
-			std::cout << std::format("OP INCREMENT {} {} upvalue: {}", sign, fix, chunk->bytecode[offset++]) << std::endl; break;
+			std::cout << fmt::format("OP INCREMENT {} {} upvalue: {}", sign, fix, chunk->bytecode[offset++]) << std::endl; break;
 		}
 		case 2: {
 			uInt constant = chunk->bytecode[offset++];
-			std::cout << std::format("OP INCREMENT {} {} global: {} \n", sign, fix, constant);
+			std::cout << fmt::format("OP INCREMENT {} {} global: {} \n", sign, fix, constant);
 			break;
 		}
 		case 3: {
 			uInt constant = chunk->bytecode[offset++];
 			constant |= chunk->bytecode[offset++];
-			std::cout << std::format("OP INCREMENT {} {} global 16-bit: {} \n", sign, fix, constant);
+			std::cout << fmt::format("OP INCREMENT {} {} global 16-bit: {} \n", sign, fix, constant);
 			break;
 		}
 		case 4: {
 			uInt constant = chunk->bytecode[offset++];
-			std::cout << std::format("OP INCREMENT {} {} dot access: {} ", sign, fix, constant);
+			std::cout << fmt::format("OP INCREMENT {} {} dot access: {} ", sign, fix, constant);
 			chunk->constants[constant].print();
 			std::cout << std::endl;
 			break;
@@ -150,13 +150,13 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 		case 5: {
 			uInt constant = chunk->bytecode[offset++];
 			constant |= chunk->bytecode[offset++];
-			std::cout << std::format("OP INCREMENT {} {} dot access 16-bit: {} ", sign, fix, constant);
+			std::cout << fmt::format("OP INCREMENT {} {} dot access 16-bit: {} ", sign, fix, constant);
 			chunk->constants[constant].print();
 			std::cout << std::endl;
 			break;
 		}
 		case 6: {
-			std::cout << std::format("OP INCREMENT {} {} field access", sign, fix) << std::endl; break;
+			std::cout << fmt::format("OP INCREMENT {} {} field access", sign, fix) << std::endl; break;
 		}
 		}
 		return offset;
@@ -219,6 +219,8 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 		return byteInstruction("OP SET UPVALUE", chunk, offset);
 	case +OpCode::CREATE_ARRAY:
 		return byteInstruction("OP CREATE ARRAY", chunk, offset);
+	case +OpCode::CREATE_MAP:
+		return byteInstruction("OP CREATE MAP", chunk, offset);
 	case +OpCode::GET:
 		return simpleInstruction("OP GET", offset);
 	case +OpCode::SET:
@@ -239,54 +241,56 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 		uint16_t toPop = chunk->bytecode[offset + 1];
 		uint16_t jump = (uint16_t)(chunk->bytecode[offset + 2] << 8);
 		jump |= chunk->bytecode[offset + 3];
-		std::cout << std::format("{:16} {:4d} -> {} POP {}", "OP JUMP POPN", offset, offset + 4 + jump, toPop) << std::endl;
+		std::cout << fmt::format("{:16} {:4d} -> {} POP {}", "OP JUMP POPN", offset, offset + 4 + jump, toPop) << std::endl;
 		return offset + 4;
 	}
 	case +OpCode::SWITCH: {
 		offset++;
 		uInt16 numOfConstants = static_cast<uInt16>(chunk->bytecode[offset++] << 8);
 		numOfConstants |= chunk->bytecode[offset++];
-		std::cout << std::format("{:16} {:4d} ", "OP SWITCH", numOfConstants) << std::endl;
+		std::cout << fmt::format("{:16} {:4d} ", "OP SWITCH", numOfConstants) << std::endl;
 		uInt jumps = offset + numOfConstants;
 
 		for (int i = 0; i < numOfConstants; i++) {
 			uInt constant = chunk->bytecode[offset++];
-			std::cout << std::format("{:0>4d}    | {:16} {:4d} ", offset - 1, "CASE CONSTANT", constant);
+			std::cout << fmt::format("{:0>4d}    | {:16} {:4d} ", offset - 1, "CASE CONSTANT", constant);
 			chunk->constants[constant].print();
 			uInt16 caseJmp = (uInt16)(chunk->bytecode[jumps + i * 2] << 8) | chunk->bytecode[(jumps + i * 2) + 1];
-			std::cout << std::format(" {} -> {:4d}", jumps + i * 2, jumps + i * 2 + 2 + caseJmp) << std::endl;
+			std::cout << fmt::format(" {} -> {:4d}", jumps + i * 2, jumps + i * 2 + 2 + caseJmp) << std::endl;
 		}
 		uInt16 defaultJmp = static_cast<uInt16>(chunk->bytecode[jumps + numOfConstants * 2] << 8) | chunk->bytecode[(jumps + numOfConstants * 2) + 1];
-		std::cout << std::format("{:0>4d}    | {:16} {} -> {:4d} ", jumps + numOfConstants * 2, "DEFAULT CASE", jumps + numOfConstants * 2, jumps + numOfConstants * 2 + 2+ defaultJmp) << std::endl;
+		std::cout << fmt::format("{:0>4d}    | {:16} {} -> {:4d} ", jumps + numOfConstants * 2, "DEFAULT CASE", jumps + numOfConstants * 2, jumps + numOfConstants * 2 + 2+ defaultJmp) << std::endl;
 		return jumps + (numOfConstants + 1) * 2;
 	}
 	case +OpCode::SWITCH_LONG: {
 		offset++;
 		uInt16 numOfConstants = (uInt16)(chunk->bytecode[offset++] << 8);
 		numOfConstants |= chunk->bytecode[offset++];
-		std::cout << std::format("{:16} {:4d} ", "OP SWITCH LONG", numOfConstants) << std::endl;;
+		std::cout << fmt::format("{:16} {:4d} ", "OP SWITCH LONG", numOfConstants) << std::endl;;
 		uInt jumps = offset + numOfConstants*2;
 
 		for (int i = 0; i < numOfConstants; i++) {
 			uInt constant = (static_cast<uInt16>(chunk->bytecode[offset] << 8) | chunk->bytecode[offset + 1]);
-			std::cout << std::format("{:0>4d}    | {:16} {:4d} ", offset, "CASE CONSTANT", constant);
+			std::cout << fmt::format("{:0>4d}    | {:16} {:4d} ", offset, "CASE CONSTANT", constant);
 			chunk->constants[constant].print();
 			uInt16 caseJmp = (uInt16)(chunk->bytecode[jumps + i * 2] << 8) | chunk->bytecode[(jumps + i * 2) + 1];
-			std::cout << std::format(" {} -> {:4d}", jumps + i * 2, jumps + i * 2 + 2 + caseJmp) << std::endl;
+			std::cout << fmt::format(" {} -> {:4d}", jumps + i * 2, jumps + i * 2 + 2 + caseJmp) << std::endl;
 			offset += 2;
 		}
 		uInt16 defaultJmp = static_cast<uInt16>(chunk->bytecode[jumps + numOfConstants * 2] << 8) | chunk->bytecode[(jumps + numOfConstants * 2) + 1];
-		std::cout << std::format("{:0>4d}    | {:16} -> {:4d} ", jumps + numOfConstants * 2, "DEFAULT CASE", jumps + numOfConstants * 2 + 2 + defaultJmp) << std::endl;
+		std::cout << fmt::format("{:0>4d}    | {:16} -> {:4d} ", jumps + numOfConstants * 2, "DEFAULT CASE", jumps + numOfConstants * 2 + 2 + defaultJmp) << std::endl;
 		return jumps + (numOfConstants + 1) * 2;
 	}
 	case +OpCode::CALL:
 		return byteInstruction("OP CALL", chunk, offset);
+	case +OpCode::TAIL_CALL:
+		return byteInstruction("OP TAIL CALL", chunk, offset);
 	case +OpCode::RETURN:
 		return simpleInstruction("OP RETURN", offset);
 	case +OpCode::CLOSURE: {
 		offset++;
 		uInt constant = chunk->bytecode[offset++];
-		std::cout << std::format("{:16} {:4d} ", "OP CLOSURE", constant);
+		std::cout << fmt::format("{:16} {:4d} ", "OP CLOSURE", constant);
 		chunk->constants[constant].print();
 		std::cout << std::endl;
 
@@ -294,7 +298,7 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 		for (int j = 0; j < function->upvalueCount; j++) {
 			int isLocal = chunk->bytecode[offset++];
 			int index = chunk->bytecode[offset++];
-			std::cout << std::format("{:0>4d}    |                     {} index: {}\n", offset - 2, isLocal ? "local" : "upvalue", index) << std::endl;
+			std::cout << fmt::format("{:0>4d}    |                     {} index: {}\n", offset - 2, isLocal ? "local" : "upvalue", index) << std::endl;
 		}
 		return offset;
 	}
@@ -302,7 +306,7 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 		offset++;
 		uInt constant = ((chunk->bytecode[offset] << 8) | chunk->bytecode[offset + 1]);
 		offset += 2;
-		std::cout << std::format("{:16} {:4d} ", "OP CLOSURE LONG", constant);
+		std::cout << fmt::format("{:16} {:4d} ", "OP CLOSURE LONG", constant);
 		chunk->constants[constant].print();
 		std::cout << std::endl;
 
@@ -310,7 +314,7 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 		for (int j = 0; j < function->upvalueCount; j++) {
 			int isLocal = chunk->bytecode[offset++];
 			int index = chunk->bytecode[offset++];
-			std::cout << std::format("{:0>4d}    |                     {} index: {}\n", offset - 2, isLocal ? "local" : "upvalue", index) << std::endl;
+			std::cout << fmt::format("{:0>4d}    |                     {} index: {}\n", offset - 2, isLocal ? "local" : "upvalue", index) << std::endl;
 		}
 		return offset;
 	}
@@ -331,20 +335,20 @@ int disassembleInstruction(Chunk* chunk, int offset) {
 	case +OpCode::CREATE_STRUCT: {
 		offset++;
 		uint8_t fieldNum = chunk->bytecode[offset++];
-		std::cout << std::format("{:16} {:4d}", "OP CREATE STRUCT", fieldNum) << std::endl;
+		std::cout << fmt::format("{:16} {:4d}", "OP CREATE STRUCT", fieldNum) << std::endl;
 		for (int i = 0; i < fieldNum; i++) {
 			int constant = chunk->bytecode[offset++];
-			std::cout << std::format("{:0>4d}    | {:16} {:4d}", offset - 1, "FIELD CONSTANT", constant) << std::endl;
+			std::cout << fmt::format("{:0>4d}    | {:16} {:4d}", offset - 1, "FIELD CONSTANT", constant) << std::endl;
 		}
 		return offset;
 	}
 	case +OpCode::CREATE_STRUCT_LONG: {
 		offset++;
 		uint8_t fieldNum = chunk->bytecode[offset++];
-		std::cout << std::format("{:16} {:4d}", "OP CREATE STRUCT LONG", fieldNum) << std::endl;
+		std::cout << fmt::format("{:16} {:4d}", "OP CREATE STRUCT LONG", fieldNum) << std::endl;
 		for (int i = 0; i < fieldNum; i++) {
 			uInt constant = ((chunk->bytecode[offset] << 8) | chunk->bytecode[offset + 1]);;
-			std::cout << std::format("{:0>4d}    | {:16} {:4d}", offset, "FIELD CONSTANT", constant) << std::endl;
+			std::cout << fmt::format("{:0>4d}    | {:16} {:4d}", offset, "FIELD CONSTANT", constant) << std::endl;
 			offset += 2;
 		}
 		return offset;
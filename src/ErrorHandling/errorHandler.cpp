@@ -1,6 +1,8 @@
 #include "errorHandler.h"
 #include "../Preprocessing/scanner.h"
 #include <iostream>
+#include <map>
+#include <mutex>
 
 //name:line:column: error: msg
 //line
@@ -14,15 +16,16 @@ const string yellow = "\u001b[38;5;220m";
 
 // Highlights a token
 void highlightToken(Token token) {
-	File* src = token.str.sourceFile;
+	Span span = token.getSpan();
+	File* src = span.sourceFile;
 
-	string lineNumber = std::to_string(token.str.line + 1);
+	string lineNumber = std::to_string(span.line + 1);
 	std::cout << yellow << src->name << black << ":" << cyan << lineNumber << " | " << black;
-	std::cout << token.str.getLine() << std::endl;
+	std::cout << span.getLine() << std::endl;
 
 	string highlight;
-	highlight.insert(highlight.end(), src->name.length() + lineNumber.length() + 4 + token.str.column, ' ');
-	highlight.insert(highlight.end(), token.str.length, '^');
+	highlight.insert(highlight.end(), src->name.length() + lineNumber.length() + 4 + span.column, ' ');
+	highlight.insert(highlight.end(), span.length, '^');
 
 	std::cout << red << highlight << black << "\n";
 }
@@ -49,8 +52,9 @@ void logDefinitionPath(Token token) {
 }
 */
 void report(File* src, Token& token, string msg) {
-	if (token.type == TokenType::TOKEN_EOF) {
-		std::cout << "End of file. \n" << msg;
+	//synthetic tokens don't have a position that could be highlighted
+	if (token.getSpan().sourceFile == nullptr) {
+		std::cout << red + "error: " + black + msg + "\n\n";
 		return;
 	}
 	string name = "\u001b[38;5;220m" + src->name + black;
@@ -100,6 +104,12 @@ namespace errorHandler {
 		vector<RuntimeError> runtimeErrors;
 		//system level errors(eg. not being able to access a file)
 		vector<SystemError> systemErrors;
+
+		//errors of modules processed in parallel, keyed by buffer id
+		std::map<uInt, vector<CompileTimeError>> bufferedErrors;
+		std::mutex errorMtx;
+		//buffer the calling thread is reporting into, -1 if errors are reported immediately
+		thread_local int64_t currentBuffer = -1;
 	}
 
 	void showCompileErrors() {
@@ -117,17 +127,45 @@ namespace errorHandler {
 		}
 	}
 
-	void addCompileError(string msg, Token token) {
-		compileErrors.push_back(CompileTimeError(msg, token.str.sourceFile, token));
+	void addCompileError(string msg, const Token& token) {
+		std::scoped_lock<std::mutex> lk(errorMtx);
+		if (currentBuffer != -1) {
+			bufferedErrors[currentBuffer].push_back(CompileTimeError(msg, token.getSpan().sourceFile, token));
+			return;
+		}
+		compileErrors.push_back(CompileTimeError(msg, token.getSpan().sourceFile, token));
 	}
 	void addRuntimeError(string msg, string funcName, CSLModule* origin) {
 		runtimeErrors.push_back(RuntimeError(msg, origin, funcName));
 	}
 	void addSystemError(string msg) {
+		std::scoped_lock<std::mutex> lk(errorMtx);
 		systemErrors.push_back(SystemError(msg));
 	}
 
 	bool hasErrors() {
 		return !compileErrors.empty() || !runtimeErrors.empty() || !systemErrors.empty();
 	}
+
+	void clearErrors() {
+		std::scoped_lock<std::mutex> lk(errorMtx);
+		compileErrors.clear();
+		runtimeErrors.clear();
+		systemErrors.clear();
+		bufferedErrors.clear();
+	}
+
+	void beginErrorBuffer(uInt id) {
+		currentBuffer = id;
+	}
+	void endErrorBuffer() {
+		currentBuffer = -1;
+	}
+	void flushErrorBuffers() {
+		std::scoped_lock<std::mutex> lk(errorMtx);
+		for (auto& [id, errors] : bufferedErrors) {
+			compileErrors.insert(compileErrors.end(), errors.begin(), errors.end());
+		}
+		bufferedErrors.clear();
+	}
 }
\ No newline at end of file
@@ -7,10 +7,28 @@ namespace errorHandler {
 	void showRuntimeErrors();
 	void showSystemErrors();
 
-	void addCompileError(string msg, Token token);
+	void addCompileError(string msg, const Token& token);
 	void addRuntimeError(string msg, string funcName, CSLModule* origin);
 	void addSystemError(string msg);
 	bool hasErrors();
+	// Forgets all reported errors, used when the same process builds the project more than once
+	void clearErrors();
+
+	// Compile errors reported on the calling thread are held in buffer 'id' instead of being reported immediately,
+	// used when modules are processed in parallel so that the order of errors doesn't depend on thread scheduling
+	void beginErrorBuffer(uInt id);
+	void endErrorBuffer();
+	// Reports all buffered errors in order of buffer ids
+	void flushErrorBuffers();
+
+	// Reports into buffer 'id' for as long as it's alive, so the buffer is ended even if the task throws
+	class ErrorBufferGuard {
+	public:
+		explicit ErrorBufferGuard(uInt id) { beginErrorBuffer(id); }
+		~ErrorBufferGuard() { endErrorBuffer(); }
+		ErrorBufferGuard(const ErrorBufferGuard&) = delete;
+		ErrorBufferGuard& operator=(const ErrorBufferGuard&) = delete;
+	};
 
 	class SystemException {
 
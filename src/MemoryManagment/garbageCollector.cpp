@@ -1,6 +1,6 @@
 #include "garbageCollector.h"
 #include "../ErrorHandling/errorHandler.h"
-#include "../codegen/compiler.h"
+#include "../Codegen/compiler.h"
 #include "../Objects/objects.h"
 #include "../Runtime/vm.h"
 #include "../Includes/fmt/format.h"
@@ -38,7 +38,8 @@ namespace memory {
 		markRoots(vm);
 		mark();
 		sweep();
-		if (heapSize > heapSizeLimit) heapSizeLimit << 1;
+		//the heap is allowed to grow to twice what survived, otherwise a large live heap would be collected on every allocation
+		if (heapSize > heapSizeLimit) heapSizeLimit = heapSize * 2;
 		// After sweeping the heap all sleeping child threads are awakened
 		{
 			std::scoped_lock<std::mutex> lk(vm->pauseMtx);
@@ -51,7 +52,7 @@ namespace memory {
 		markRoots(compiler);
 		mark();
 		sweep();
-		if (heapSize > heapSizeLimit) heapSizeLimit << 1;
+		if (heapSize > heapSizeLimit) heapSizeLimit = heapSize * 2;
 		shouldCollect = false;
 	}
 
@@ -90,6 +91,17 @@ namespace memory {
 	}
 
 	void GarbageCollector::markObj(object::Obj* object) {
-		markStack.push_back(object);
+		//objects that don't reference anything are marked right away, this keeps eg. large typed arrays off the mark stack
+		switch (object->type) {
+		case object::ObjType::STRING:
+		case object::ObjType::STRING_BUILDER:
+		case object::ObjType::TYPED_ARRAY:
+		case object::ObjType::NATIVE:
+		case object::ObjType::FUNC:
+			object->marked = true;
+			return;
+		default:
+			markStack.push_back(object);
+		}
 	}
 }
@@ -1,6 +1,23 @@
 #include "objects.h"
 #include "../MemoryManagment/garbageCollector.h"
 #include "../Runtime/thread.h"
+#include <algorithm>
+#include <filesystem>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MAP_GROUP_SSE2
+#include <emmintrin.h>
+#endif
 
 using namespace object;
 using namespace memory;
@@ -11,6 +28,11 @@ ObjString::ObjString(string& _str) {
 	marked = false;
 	type = ObjType::STRING;
 }
+ObjString::ObjString(string&& _str) {
+	str = std::move(_str);
+	marked = false;
+	type = ObjType::STRING;
+}
 uInt64 ObjString::getSize() {
 	//+1 for terminator byte
 	return sizeof(ObjString);
@@ -32,8 +54,29 @@ bool ObjString::compare(string other) {
 }
 
 ObjString* ObjString::concat(ObjString* other) {
-	string temp = str + other->str;
-	return new ObjString(temp);
+	string temp;
+	temp.reserve(str.size() + other->str.size());
+	temp.append(str).append(other->str);
+	return new ObjString(std::move(temp));
+}
+#pragma endregion
+
+#pragma region ObjStringBuilder
+ObjStringBuilder::ObjStringBuilder() {
+	marked = false;
+	type = ObjType::STRING_BUILDER;
+}
+
+void ObjStringBuilder::trace() {
+	//nothing to mark
+}
+
+string ObjStringBuilder::toString() {
+	return buffer;
+}
+
+uInt64 ObjStringBuilder::getSize() {
+	return sizeof(ObjStringBuilder) + buffer.capacity();
 }
 #pragma endregion
 
@@ -62,9 +105,10 @@ uInt64 ObjFunc::getSize() {
 #pragma endregion
 
 #pragma region ObjNativeFn
-ObjNativeFunc::ObjNativeFunc(NativeFn _func, byte _arity) {
+ObjNativeFunc::ObjNativeFunc(NativeFn _func, int _arity, string _name) {
 	func = _func;
 	arity = _arity;
+	name = _name;
 	marked = false;
 	type = ObjType::NATIVE;
 }
@@ -74,7 +118,7 @@ void ObjNativeFunc::trace() {
 }
 
 string ObjNativeFunc::toString() {
-	return "<native function>";
+	return "<native " + name + ">";
 }
 
 uInt64 ObjNativeFunc::getSize() {
@@ -126,6 +170,68 @@ uInt64 ObjUpval::getSize() {
 }
 #pragma endregion
 
+#pragma region ObjStringSlice
+//parents smaller than this are never worth copying out of
+#define SLICE_COMPACT_MIN_PARENT 1024
+//a slice is compacted if it's parent is more than this many times larger
+#define SLICE_COMPACT_RATIO 8
+
+static std::string_view parentView(Obj* parent) {
+	if (parent->type == ObjType::STRING) return static_cast<ObjString*>(parent)->str;
+	return static_cast<ObjFile*>(parent)->mappedView();
+}
+
+ObjStringSlice::ObjStringSlice(Obj* _parent, uInt64 _offset, uInt64 _length) {
+	parent = _parent;
+	offset = _offset;
+	length = _length;
+	marked = false;
+	type = ObjType::STRING_SLICE;
+}
+
+ObjStringSlice::ObjStringSlice(std::string_view str) {
+	parent = nullptr;
+	offset = 0;
+	length = str.size();
+	owned = string(str);
+	marked = false;
+	type = ObjType::STRING_SLICE;
+}
+
+std::string_view ObjStringSlice::view() {
+	if (!parent) return owned;
+	return parentView(parent).substr(offset, length);
+}
+
+ObjStringSlice* ObjStringSlice::slice(uInt64 start, uInt64 len) {
+	//always points to the original string, so that there are never chains of slices
+	if (parent) return new ObjStringSlice(parent, offset + start, len);
+	//owned slices are small by definition, copying is cheap
+	return new ObjStringSlice(view().substr(start, len));
+}
+
+//tracing is done while every thread is paused, so the slice can safely switch to owning it's characters
+void ObjStringSlice::trace() {
+	if (!parent) return;
+	uInt64 parentSize = parentView(parent).size();
+	if (parentSize >= SLICE_COMPACT_MIN_PARENT && length * SLICE_COMPACT_RATIO < parentSize) {
+		owned = string(view());
+		parent = nullptr;
+		offset = 0;
+		return;
+	}
+	gc.markObj(parent);
+}
+
+string ObjStringSlice::toString() {
+	return string(view());
+}
+
+uInt64 ObjStringSlice::getSize() {
+	return sizeof(ObjStringSlice) + owned.capacity();
+}
+#pragma endregion
+
 #pragma region ObjArray
 ObjArray::ObjArray() {
 	type = ObjType::ARRAY;
@@ -136,6 +242,7 @@ ObjArray::ObjArray(size_t size) {
 	values = vector<Value>(size);
 	type = ObjType::ARRAY;
 	numOfHeapPtr = 0;
+	marked = false;
 }
 
 //small optimization: if numOfHeapPtrs is 0 then we don't even scan the array for objects
@@ -147,6 +254,7 @@ void ObjArray::trace() {
 	while (i < arrSize && temp < numOfHeapPtr) {
 		values[i].mark();
 		if (values[i].isObj()) temp++;
+		i++;
 	}
 }
 
@@ -159,6 +267,275 @@ uInt64 ObjArray::getSize() {
 }
 #pragma endregion
 
+#pragma region ObjTypedArray
+#define TYPED_ARRAY_ALIGNMENT 32
+
+ObjTypedArray::ObjTypedArray(TypedArrayKind _kind, uInt64 _length) {
+	kind = _kind;
+	length = _length;
+	uInt64 bytes = std::max<uInt64>(length * elementSize(), 1);
+	data = static_cast<byte*>(::operator new[](bytes, std::align_val_t(TYPED_ARRAY_ALIGNMENT)));
+	memset(data, 0, bytes);
+	marked = false;
+	type = ObjType::TYPED_ARRAY;
+}
+
+ObjTypedArray::~ObjTypedArray() {
+	::operator delete[](data, std::align_val_t(TYPED_ARRAY_ALIGNMENT));
+}
+
+uInt64 ObjTypedArray::elementSize() {
+	switch (kind) {
+	case TypedArrayKind::FLOAT64: return sizeof(double);
+	case TypedArrayKind::INT32: return sizeof(int32_t);
+	case TypedArrayKind::UINT8: return sizeof(uint8_t);
+	}
+	return 0;
+}
+
+double ObjTypedArray::get(uInt64 index) {
+	switch (kind) {
+	case TypedArrayKind::FLOAT64: return as<double>()[index];
+	case TypedArrayKind::INT32: return as<int32_t>()[index];
+	case TypedArrayKind::UINT8: return as<uint8_t>()[index];
+	}
+	return 0;
+}
+
+//casting a double that doesn't fit in the target type is undefined, so integer stores work like JS ToInt32:
+//NaN and infinities become 0, anything else is truncated and wrapped around modulo 2^32
+static uint32_t wrapToUint32(double val) {
+	if (!std::isfinite(val)) return 0;
+	double wrapped = std::fmod(std::trunc(val), 4294967296.0);
+	if (wrapped < 0) wrapped += 4294967296.0;
+	return static_cast<uint32_t>(wrapped);
+}
+
+void ObjTypedArray::set(uInt64 index, double val) {
+	switch (kind) {
+	case TypedArrayKind::FLOAT64: as<double>()[index] = val; break;
+	//narrowing unsigned integers wraps, 2^32 is a multiple of 2^8 so uint8 stores wrap modulo 2^8
+	case TypedArrayKind::INT32: as<int32_t>()[index] = static_cast<int32_t>(wrapToUint32(val)); break;
+	case TypedArrayKind::UINT8: as<uint8_t>()[index] = static_cast<uint8_t>(wrapToUint32(val)); break;
+	}
+}
+
+void ObjTypedArray::trace() {
+	//nothing to mark
+}
+
+string ObjTypedArray::toString() {
+	switch (kind) {
+	case TypedArrayKind::FLOAT64: return "<Float64Array>";
+	case TypedArrayKind::INT32: return "<Int32Array>";
+	case TypedArrayKind::UINT8: return "<Uint8Array>";
+	}
+	return "<typed array>";
+}
+
+uInt64 ObjTypedArray::getSize() {
+	return sizeof(ObjTypedArray) + length * elementSize();
+}
+#pragma endregion
+
+#pragma region ObjMap
+#define MAP_GROUP_SIZE 16
+#define MAP_CTRL_EMPTY ((int8_t)-128)
+#define MAP_CTRL_DELETED ((int8_t)-2)
+
+//bitmask of the slots in the group whose control byte is 'tag'
+static uInt groupMatch(const int8_t* group, int8_t tag) {
+#ifdef MAP_GROUP_SSE2
+	__m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+#else
+	uInt mask = 0;
+	for (int i = 0; i < MAP_GROUP_SIZE; i++) if (group[i] == tag) mask |= 1u << i;
+	return mask;
+#endif
+}
+
+//bitmask of the slots in the group that are empty or deleted, both have the top bit set
+static uInt groupFree(const int8_t* group) {
+#ifdef MAP_GROUP_SSE2
+	return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+	uInt mask = 0;
+	for (int i = 0; i < MAP_GROUP_SIZE; i++) if (group[i] < 0) mask |= 1u << i;
+	return mask;
+#endif
+}
+
+static uInt64 mixHash(uInt64 x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static bool isStringKey(Value& key) {
+	return key.isString() || key.isStringSlice();
+}
+
+static std::string_view keyView(Value& key) {
+	if (key.isString()) return key.asString()->str;
+	return key.asStringSlice()->view();
+}
+
+static uInt64 hashKey(Value& key) {
+	if (key.isNumber()) {
+		//-0 and 0 are the same key
+		double num = key.asNumber() == 0 ? 0 : key.asNumber();
+		return mixHash(std::bit_cast<uInt64>(num));
+	}
+	if (key.isBool()) return mixHash(key.asBool() ? 1 : 2);
+	if (key.isNil()) return mixHash(3);
+	if (isStringKey(key)) return mixHash(std::hash<std::string_view>{}(keyView(key)));
+	return mixHash(reinterpret_cast<uInt64>(key.asObj()));
+}
+
+//numbers are compared exactly, unlike ==
+static bool keysEqual(Value& a, Value& b) {
+	if (a.isNumber()) return b.isNumber() && a.asNumber() == b.asNumber();
+	if (isStringKey(a)) return isStringKey(b) && keyView(a) == keyView(b);
+	return a.value == b.value;
+}
+
+ObjMap::ObjMap() {
+	ctrl = nullptr;
+	slots = nullptr;
+	capacity = 0;
+	count = 0;
+	tombstones = 0;
+	marked = false;
+	type = ObjType::MAP;
+}
+
+ObjMap::~ObjMap() {
+	delete[] ctrl;
+	delete[] slots;
+}
+
+//groups are probed in triangular order(+1, +2, +3...), which visits every group when their number is a power of 2
+int64_t ObjMap::find(Value& key, uInt64 hash) {
+	if (capacity == 0) return -1;
+	uInt64 groupMask = capacity / MAP_GROUP_SIZE - 1;
+	uInt64 group = (hash >> 7) & groupMask;
+	int8_t tag = hash & 0x7F;
+	for (uInt64 probe = 0; probe <= groupMask; probe++) {
+		int8_t* groupCtrl = ctrl + group * MAP_GROUP_SIZE;
+		uInt mask = groupMatch(groupCtrl, tag);
+		while (mask != 0) {
+			uInt64 slot = group * MAP_GROUP_SIZE + std::countr_zero(mask);
+			if (keysEqual(slots[slot].key, key)) return slot;
+			mask &= mask - 1;
+		}
+		//if the key was ever inserted it would've taken this empty slot
+		if (groupMatch(groupCtrl, MAP_CTRL_EMPTY) != 0) return -1;
+		group = (group + probe + 1) & groupMask;
+	}
+	return -1;
+}
+
+//'key' must not be in the map and there must be a free slot
+void ObjMap::insertNew(Value& key, Value& val, uInt64 hash) {
+	uInt64 groupMask = capacity / MAP_GROUP_SIZE - 1;
+	uInt64 group = (hash >> 7) & groupMask;
+	for (uInt64 probe = 0; ; probe++) {
+		uInt mask = groupFree(ctrl + group * MAP_GROUP_SIZE);
+		if (mask != 0) {
+			uInt64 slot = group * MAP_GROUP_SIZE + std::countr_zero(mask);
+			if (ctrl[slot] == MAP_CTRL_DELETED) tombstones--;
+			ctrl[slot] = hash & 0x7F;
+			slots[slot].key = key;
+			slots[slot].val = val;
+			count++;
+			return;
+		}
+		group = (group + probe + 1) & groupMask;
+	}
+}
+
+void ObjMap::rehash(uInt64 newCapacity) {
+	int8_t* oldCtrl = ctrl;
+	Entry* oldSlots = slots;
+	uInt64 oldCapacity = capacity;
+
+	ctrl = new int8_t[newCapacity];
+	memset(ctrl, MAP_CTRL_EMPTY, newCapacity);
+	slots = new Entry[newCapacity];
+	capacity = newCapacity;
+	count = 0;
+	tombstones = 0;
+	for (uInt64 i = 0; i < oldCapacity; i++) {
+		if (oldCtrl[i] >= 0) insertNew(oldSlots[i].key, oldSlots[i].val, hashKey(oldSlots[i].key));
+	}
+	delete[] oldCtrl;
+	delete[] oldSlots;
+}
+
+Value* ObjMap::get(Value key) {
+	int64_t slot = find(key, hashKey(key));
+	return slot == -1 ? nullptr : &slots[slot].val;
+}
+
+void ObjMap::set(Value key, Value val) {
+	uInt64 hash = hashKey(key);
+	int64_t slot = find(key, hash);
+	if (slot != -1) {
+		slots[slot].val = val;
+		return;
+	}
+	//a slice would keep it's whole parent alive for as long as it's a key
+	if (key.isStringSlice()) key = Value(new ObjString(string(key.asStringSlice()->view())));
+	//max load factor is 7/8, tombstones count since they lengthen probe sequences
+	if ((count + tombstones + 1) * 8 > capacity * 7) {
+		//if most of the used slots are tombstones, rehashing at the same size is enough to get rid of them
+		uInt64 newCapacity = capacity == 0 ? MAP_GROUP_SIZE : ((count + 1) * 2 > capacity ? capacity * 2 : capacity);
+		rehash(newCapacity);
+	}
+	insertNew(key, val, hash);
+}
+
+bool ObjMap::remove(Value key) {
+	int64_t slot = find(key, hashKey(key));
+	if (slot == -1) return false;
+	//a group that still has an empty slot never made a probe continue past it, so the slot can become empty again
+	int8_t* groupCtrl = ctrl + (slot / MAP_GROUP_SIZE) * MAP_GROUP_SIZE;
+	if (groupMatch(groupCtrl, MAP_CTRL_EMPTY) != 0) ctrl[slot] = MAP_CTRL_EMPTY;
+	else {
+		ctrl[slot] = MAP_CTRL_DELETED;
+		tombstones++;
+	}
+	slots[slot] = Entry();
+	count--;
+	return true;
+}
+
+void ObjMap::trace() {
+	//free slots are skipped a whole group at a time
+	for (uInt64 group = 0; group < capacity; group += MAP_GROUP_SIZE) {
+		uInt mask = ~groupFree(ctrl + group) & 0xFFFF;
+		while (mask != 0) {
+			Entry& entry = slots[group + std::countr_zero(mask)];
+			entry.key.mark();
+			entry.val.mark();
+			mask &= mask - 1;
+		}
+	}
+}
+
+string ObjMap::toString() {
+	return "<map>";
+}
+
+uInt64 ObjMap::getSize() {
+	return sizeof(ObjMap) + capacity * (sizeof(Entry) + 1);
+}
+#pragma endregion
+
 #pragma region ObjClass
 ObjClass::ObjClass(string _name) {
 	name = _name;
@@ -228,14 +605,62 @@ uInt64 ObjBoundMethod::getSize() {
 #pragma endregion
 
 #pragma region ObjFile
-ObjFile::ObjFile(string& _path) {
+//large reads and writes go straight to the OS in big chunks instead of the default few KB
+#define FILE_BUFFER_SIZE (1 << 20)
+
+ObjFile::ObjFile(string& _path, FileMode _mode) {
 	path = _path;
+	mode = _mode;
+	readPos = 0;
+	pollFd = -1;
 	marked = false;
-	stream.open(path);
 	type = ObjType::FILE;
+	if (mode == FileMode::MAPPED) {
+		isOpen = std::filesystem::is_regular_file(path);
+		if (isOpen) mapping = std::make_unique<MappedFile>(path);
+		//an unreadable file is reported by openNative instead of looking like an empty one
+		if (isOpen && !mapping->isValid()) {
+			mapping = nullptr;
+			isOpen = false;
+		}
+		return;
+	}
+	ioBuffer = std::make_unique<char[]>(FILE_BUFFER_SIZE);
+	//has to be set before opening to have any effect
+	stream.rdbuf()->pubsetbuf(ioBuffer.get(), FILE_BUFFER_SIZE);
+	std::ios::openmode openMode = std::ios::binary;
+	switch (mode) {
+	case FileMode::READ: openMode |= std::ios::in; break;
+	case FileMode::WRITE: openMode |= std::ios::out | std::ios::trunc; break;
+	case FileMode::APPEND: openMode |= std::ios::out | std::ios::app; break;
+	//handled above
+	case FileMode::MAPPED: break;
+	}
+	stream.open(path, openMode);
+	isOpen = stream.is_open();
+	#ifndef _WIN32
+	if (isOpen && !std::filesystem::is_regular_file(path)) {
+		pollFd = ::open(path.c_str(), (mode == FileMode::READ ? O_RDONLY : O_WRONLY) | O_NONBLOCK | O_CLOEXEC);
+	}
+	#endif
 }
 ObjFile::~ObjFile() {
-	stream.close();
+	close();
+}
+
+void ObjFile::close() {
+	if (!isOpen) return;
+	isOpen = false;
+	//the mapping can't be released here, slices created from it are freed by the GC
+	if (mode != FileMode::MAPPED) stream.close();
+	#ifndef _WIN32
+	if (pollFd != -1) ::close(pollFd);
+	#endif
+	pollFd = -1;
+}
+
+std::string_view ObjFile::mappedView() {
+	return mapping ? mapping->getView() : std::string_view();
 }
 
 void ObjFile::trace() {
@@ -247,7 +672,116 @@ string ObjFile::toString() {
 }
 
 uInt64 ObjFile::getSize() {
-	return sizeof(ObjFile);
+	return sizeof(ObjFile) + (ioBuffer ? FILE_BUFFER_SIZE : 0);
+}
+#pragma endregion
+
+#pragma region ObjFileIterator
+//initial size of the read buffer, it only grows if a single line doesn't fit
+#define FILE_ITERATOR_BUFFER_SIZE (1 << 16)
+
+ObjFileIterator::ObjFileIterator(const string& path, uInt64 _chunkSize) {
+	chunkSize = _chunkSize;
+	bufferStart = 0;
+	bufferEnd = 0;
+	reachedEOF = false;
+	marked = false;
+	type = ObjType::FILE_ITERATOR;
+	ownsSource = !path.empty();
+	source = ownsSource ? std::fopen(path.c_str(), "rb") : stdin;
+	if (!source) return;
+	buffer.resize(std::max<uInt64>(FILE_ITERATOR_BUFFER_SIZE, chunkSize));
+	//reads go directly into 'buffer', buffering them in the FILE as well would only add a copy
+	if (ownsSource) std::setvbuf(source, nullptr, _IONBF, 0);
+	#ifdef __linux__
+	//doubles the kernel readahead window, this is a hint and failing(eg. for pipes) is harmless
+	posix_fadvise(fileno(source), 0, 0, POSIX_FADV_SEQUENTIAL);
+	#endif
+}
+ObjFileIterator::~ObjFileIterator() {
+	close();
+}
+
+void ObjFileIterator::refill(runtime::Thread* thread) {
+	//unread bytes are moved to the front, the current item is no longer needed at this point
+	if (bufferStart > 0) {
+		memmove(buffer.data(), buffer.data() + bufferStart, bufferEnd - bufferStart);
+		bufferEnd -= bufferStart;
+		bufferStart = 0;
+	}
+	if (bufferEnd == buffer.size()) buffer.resize(buffer.size() * 2);
+	#ifdef _WIN32
+	uInt64 read = std::fread(buffer.data() + bufferEnd, 1, buffer.size() - bufferEnd, source);
+	#else
+	//unlike fread, read(2) returns as soon as anything is available, so a line typed into a terminal or written to a pipe
+	//is handed out right away instead of after the buffer fills up
+	thread->waitForFd(fileno(source), false);
+	ssize_t read;
+	do {
+		read = ::read(fileno(source), buffer.data() + bufferEnd, buffer.size() - bufferEnd);
+	} while (read < 0 && errno == EINTR);
+	if (read < 0) read = 0;
+	#endif
+	bufferEnd += read;
+	if (read == 0) reachedEOF = true;
+}
+
+bool ObjFileIterator::advance(runtime::Thread* thread) {
+	current = std::string_view();
+	if (!source) return false;
+	if (chunkSize > 0) {
+		while (bufferEnd - bufferStart < chunkSize && !reachedEOF) refill(thread);
+		uInt64 length = std::min(chunkSize, bufferEnd - bufferStart);
+		if (length == 0) {
+			close();
+			return false;
+		}
+		current = std::string_view(buffer.data() + bufferStart, length);
+		bufferStart += length;
+		return true;
+	}
+	//only the bytes that weren't searched yet are scanned after a refill
+	uInt64 searched = 0;
+	while (true) {
+		const char* start = buffer.data() + bufferStart;
+		const char* newline = static_cast<const char*>(memchr(start + searched, '\n', bufferEnd - bufferStart - searched));
+		if (newline) {
+			uInt64 length = newline - start;
+			bufferStart += length + 1;
+			if (length > 0 && start[length - 1] == '\r') length--;
+			current = std::string_view(start, length);
+			return true;
+		}
+		if (reachedEOF) break;
+		searched = bufferEnd - bufferStart;
+		refill(thread);
+	}
+	//last line of a file that doesn't end with a newline
+	if (bufferStart == bufferEnd) {
+		close();
+		return false;
+	}
+	current = std::string_view(buffer.data() + bufferStart, bufferEnd - bufferStart);
+	bufferStart = bufferEnd;
+	return true;
+}
+
+void ObjFileIterator::close() {
+	if (!source) return;
+	if (ownsSource) std::fclose(source);
+	source = nullptr;
+}
+
+void ObjFileIterator::trace() {
+	//nothing
+}
+
+string ObjFileIterator::toString() {
+	return "<file iterator>";
+}
+
+uInt64 ObjFileIterator::getSize() {
+	return sizeof(ObjFileIterator) + buffer.capacity();
 }
 #pragma endregion
 
@@ -302,3 +836,188 @@ uInt64 ObjFuture::getSize() {
 }
 #pragma endregion
 
+#pragma region ObjChannel
+std::mutex ObjChannel::selectMtx;
+std::condition_variable ObjChannel::selectCv;
+std::atomic<int> ObjChannel::selectWaiters = 0;
+
+ObjChannel::ObjChannel(uInt64 _capacity) : closed(false), sendPos(0), recvPos(0), queueSize(0), waitingReceivers(0),
+	waitingSenders(0) {
+	capacity = _capacity;
+	marked = false;
+	type = ObjType::CHANNEL;
+	if (capacity == 0) return;
+	cells = std::make_unique<Cell[]>(capacity);
+	for (uInt64 i = 0; i < capacity; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+//the ring buffer is Dmitry Vyukov's bounded MPMC queue: a sender claims a cell by advancing sendPos, fills it and then
+//publishes it by bumping it's sequence number, receivers do the same with recvPos
+bool ObjChannel::push(Value val) {
+	if (capacity == 0) {
+		queue.push_back(val);
+		queueSize.store(queue.size());
+		return true;
+	}
+	uInt64 pos = sendPos.load(std::memory_order_relaxed);
+	while (true) {
+		Cell& cell = cells[pos % capacity];
+		int64_t diff = static_cast<int64_t>(cell.sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (sendPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				cell.val = val;
+				cell.sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		//the cell still holds the value sent 'capacity' sends ago
+		else if (diff < 0) return false;
+		else pos = sendPos.load(std::memory_order_relaxed);
+	}
+}
+
+bool ObjChannel::pop(Value& val) {
+	if (capacity == 0) {
+		if (queue.empty()) return false;
+		val = queue.front();
+		queue.pop_front();
+		queueSize.store(queue.size());
+		return true;
+	}
+	uInt64 pos = recvPos.load(std::memory_order_relaxed);
+	while (true) {
+		Cell& cell = cells[pos % capacity];
+		int64_t diff = static_cast<int64_t>(cell.sequence.load(std::memory_order_acquire) - (pos + 1));
+		if (diff == 0) {
+			if (recvPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				val = cell.val;
+				//the channel shouldn't keep a received value alive
+				cell.val = Value::nil();
+				cell.sequence.store(pos + capacity, std::memory_order_release);
+				return true;
+			}
+		}
+		//nothing has been sent to this cell yet
+		else if (diff < 0) return false;
+		else pos = recvPos.load(std::memory_order_relaxed);
+	}
+}
+
+bool ObjChannel::canSend() {
+	if (capacity == 0) return true;
+	uInt64 pos = sendPos.load(std::memory_order_relaxed);
+	return cells[pos % capacity].sequence.load(std::memory_order_acquire) == pos;
+}
+
+bool ObjChannel::canRecv() {
+	if (capacity == 0) return queueSize.load() > 0;
+	uInt64 pos = recvPos.load(std::memory_order_relaxed);
+	return cells[pos % capacity].sequence.load(std::memory_order_acquire) == pos + 1;
+}
+
+//a blocked thread increments the waiting counter before checking the channel one last time, and the other side checks
+//the counter after modifying the channel, the fences guarantee that at least one of them sees the other's write
+void ObjChannel::notifyReceivers() {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waitingReceivers.load() > 0) {
+		std::lock_guard<std::mutex> lk(mtx);
+		notEmpty.notify_one();
+	}
+	notifySelect();
+}
+
+void ObjChannel::notifySenders() {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waitingSenders.load() > 0) {
+		std::lock_guard<std::mutex> lk(mtx);
+		notFull.notify_one();
+	}
+}
+
+void ObjChannel::notifySelect() {
+	if (selectWaiters.load() > 0) {
+		std::lock_guard<std::mutex> lk(selectMtx);
+		selectCv.notify_all();
+	}
+}
+
+bool ObjChannel::trySend(Value val) {
+	if (capacity == 0) {
+		std::lock_guard<std::mutex> lk(mtx);
+		push(val);
+	}
+	else if (!push(val)) return false;
+	notifyReceivers();
+	return true;
+}
+
+bool ObjChannel::tryRecv(Value& val) {
+	if (capacity == 0) {
+		std::lock_guard<std::mutex> lk(mtx);
+		return pop(val);
+	}
+	if (!pop(val)) return false;
+	notifySenders();
+	return true;
+}
+
+bool ObjChannel::send(runtime::Thread* thread, Value val) {
+	if (closed.load()) return false;
+	//unbounded channels are never full
+	if (trySend(val)) return true;
+	bool sent;
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		waitingSenders.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!(sent = push(val)) && !closed.load()) {
+			thread->waitOn(lk, notFull, [&] { return canSend() || closed.load(); });
+		}
+		waitingSenders.fetch_sub(1);
+	}
+	if (sent) notifyReceivers();
+	return sent;
+}
+
+bool ObjChannel::recv(runtime::Thread* thread, Value& val) {
+	if (tryRecv(val)) return true;
+	bool received;
+	{
+		std::unique_lock<std::mutex> lk(mtx);
+		waitingReceivers.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!(received = pop(val)) && !closed.load()) {
+			thread->waitOn(lk, notEmpty, [&] { return canRecv() || closed.load(); });
+		}
+		//something might have been sent right before the channel was closed
+		if (!received) received = pop(val);
+		waitingReceivers.fetch_sub(1);
+	}
+	if (received && capacity > 0) notifySenders();
+	return received;
+}
+
+void ObjChannel::close() {
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		closed.store(true);
+		notEmpty.notify_all();
+		notFull.notify_all();
+	}
+	notifySelect();
+}
+
+//tracing is done while every thread is paused, threads blocked on the channel only read it
+void ObjChannel::trace() {
+	for (Value& val : queue) val.mark();
+	for (uInt64 i = 0; i < capacity; i++) cells[i].val.mark();
+}
+
+string ObjChannel::toString() {
+	return "<channel>";
+}
+
+uInt64 ObjChannel::getSize() {
+	return sizeof(ObjChannel) + capacity * sizeof(Cell);
+}
+#pragma endregion
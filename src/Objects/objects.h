@@ -1,11 +1,15 @@
 #pragma once
-#include "../codegen/codegenDefs.h"
+#include "../Codegen/codegenDefs.h"
 #include "../MemoryManagment/garbageCollector.h"
 #include "../Includes/robin_hood.h"
+#include "../files.h"
 #include <fstream>
 #include <stdio.h>
 #include <shared_mutex>
 #include <future>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 
 namespace runtime {
 	class VM;
@@ -16,6 +20,8 @@ namespace object {
 
 	enum class ObjType {
 		STRING,
+		STRING_BUILDER,
+		STRING_SLICE,
 		FUNC,
 		NATIVE,
 		ARRAY,
@@ -24,9 +30,13 @@ namespace object {
 		CLASS,
 		INSTANCE,
 		BOUND_METHOD,
+		TYPED_ARRAY,
+		MAP,
 		FILE,
+		FILE_ITERATOR,
 		MUTEX,
-		FUTURE
+		FUTURE,
+		CHANNEL
 	};
 
 	class Obj {
@@ -40,13 +50,16 @@ namespace object {
 		virtual ~Obj() {};
 
 		//this reroutes the new operator to take memory which the GC gives out
-		void* operator new(uInt64 size) {
+		void* operator new(size_t size) {
 			return memory::gc.alloc(size);
 		}
 	};
 
-	//pointer to a native C++ function
-	using NativeFn = bool(*)(runtime::Thread* vm, int argCount, Value* args);
+	//pointer to a native C++ function, 'args' points to the first argument and args[-1] is the slot of the callee
+	//a native stores it's result in args[-1] and returns true to have it's arguments popped, it returns false only if it
+	//already rearranged the stack itself(eg. by pushing a new call frame)
+	//errors are reported with Thread::nativeError, see Runtime/nativeRegistry.h for typed bindings
+	using NativeFn = bool(*)(runtime::Thread* thread, int argCount, Value* args);
 
 
 	//this is a header which is followed by the bytes of the string
@@ -55,6 +68,7 @@ namespace object {
 		string str;
 
 		ObjString(string& str);
+		ObjString(string&& str);
 		~ObjString() {}
 
 		bool compare(ObjString* other);
@@ -68,6 +82,44 @@ namespace object {
 		uInt64 getSize();
 	};
 
+	//mutable buffer for building strings piece by piece, appending is amortized O(1) and the contents are copied
+	//into a ObjString only once it's built, unlike repeated '+' which copies the whole string on every step
+	class ObjStringBuilder : public Obj {
+	public:
+		string buffer;
+
+		ObjStringBuilder();
+		~ObjStringBuilder() {}
+
+		void trace();
+		string toString();
+		uInt64 getSize();
+	};
+
+	//substring that points into the characters of 'parent'(a string or a memory mapped file) instead of copying them
+	//a slice that survives a collection while being much smaller than it's parent copies it's characters and lets go
+	//of the parent, so that a few short slices don't keep a huge string alive
+	class ObjStringSlice : public Obj {
+	public:
+		//nullptr once the slice owns it's characters
+		Obj* parent;
+		uInt64 offset;
+		uInt64 length;
+		string owned;
+
+		//'_parent' must be a string or a mapped file, slices of slices are created through ObjStringSlice::slice
+		ObjStringSlice(Obj* _parent, uInt64 _offset, uInt64 _length);
+		ObjStringSlice(std::string_view str);
+		~ObjStringSlice() {}
+
+		std::string_view view();
+		ObjStringSlice* slice(uInt64 start, uInt64 len);
+
+		void trace();
+		string toString();
+		uInt64 getSize();
+	};
+
 	class ObjArray : public Obj {
 	public:
 		vector<Value> values;
@@ -82,6 +134,80 @@ namespace object {
 		uInt64 getSize();
 	};
 
+	enum class TypedArrayKind {
+		FLOAT64,
+		INT32,
+		UINT8
+	};
+
+	//array of raw numbers stored contiguously, elements are converted from/to doubles when accessed from CSL
+	//holds no references to other objects so the GC never traces it
+	class ObjTypedArray : public Obj {
+	public:
+		TypedArrayKind kind;
+		uInt64 length;
+		//aligned to TYPED_ARRAY_ALIGNMENT so that bulk operations can use vector loads
+		byte* data;
+		ObjTypedArray(TypedArrayKind _kind, uInt64 _length);
+		~ObjTypedArray();
+
+		template<typename T>
+		T* as() { return reinterpret_cast<T*>(data); }
+		uInt64 elementSize();
+		double get(uInt64 index);
+		//values that don't fit into the element type are truncated towards zero and wrapped
+		void set(uInt64 index, double val);
+
+		void trace();
+		string toString();
+		uInt64 getSize();
+	};
+
+	//hash map keyed by any value: numbers by value, strings(and slices) by contents, everything else by identity
+	//open addressing with a control byte per slot(SwissTable layout), lookups compare the control bytes of 16 slots at
+	//once and only look at slots whose 7 bit hash fragment matches
+	class ObjMap : public Obj {
+	public:
+		struct Entry {
+			Value key;
+			Value val;
+		};
+
+		ObjMap();
+		~ObjMap();
+
+		//nullptr if 'key' isn't in the map, the pointer is invalidated by the next insertion
+		Value* get(Value key);
+		void set(Value key, Value val);
+		//returns false if 'key' wasn't in the map
+		bool remove(Value key);
+		uInt64 size() { return count; }
+
+		//calls 'func' with every entry, in no particular order
+		template<typename F>
+		void forEach(F&& func) {
+			for (uInt64 i = 0; i < capacity; i++) {
+				if (ctrl[i] >= 0) func(slots[i]);
+			}
+		}
+
+		void trace();
+		string toString();
+		uInt64 getSize();
+	private:
+		//for every slot: EMPTY, DELETED or 7 bits of the hash of the key in the slot
+		int8_t* ctrl;
+		Entry* slots;
+		//always 0 or a power of 2 that's at least the size of a group
+		uInt64 capacity;
+		uInt64 count;
+		uInt64 tombstones;
+
+		int64_t find(Value& key, uInt64 hash);
+		void insertNew(Value& key, Value& val, uInt64 hash);
+		void rehash(uInt64 newCapacity);
+	};
+
 	class ObjFunc : public Obj {
 	public:
 		uInt64 bytecodeOffset;
@@ -101,8 +227,10 @@ namespace object {
 	class ObjNativeFunc : public Obj {
 	public:
 		NativeFn func;
-		byte arity;
-		ObjNativeFunc(NativeFn _func, byte _arity);
+		string name;
+		//-1 if the function takes a variable number of arguments
+		int arity;
+		ObjNativeFunc(NativeFn _func, int _arity, string _name);
 		~ObjNativeFunc() {}
 
 		void trace();
@@ -174,19 +302,78 @@ namespace object {
 		uInt64 getSize();
 	};
 
+	enum class FileMode {
+		READ,
+		WRITE,
+		APPEND,
+		//read only, the whole file is mapped into memory and read without copying
+		MAPPED
+	};
+
 	class ObjFile : public Obj {
 	public:
 		std::fstream stream;
 		string path;
-
-		ObjFile(string& path);
+		FileMode mode;
+		bool isOpen;
+		//only used in MAPPED mode, stays alive until the file is collected since slices might point into it
+		std::unique_ptr<MappedFile> mapping;
+		//position of the next read in MAPPED mode
+		uInt64 readPos;
+		//reused by every readLine so that reading doesn't allocate for each line
+		string lineBuffer;
+		std::unique_ptr<char[]> ioBuffer;
+		//-1 unless 'path' is a pipe, terminal or other file that reads and writes can block on indefinitely
+		//fstream doesn't expose its descriptor, so this is a second one to the same file that's only used for waiting
+		int pollFd;
+
+		//check isOpen to see if opening succeeded
+		ObjFile(string& path, FileMode _mode);
 		~ObjFile();
 
+		//releases the OS handle right away instead of waiting for the GC
+		void close();
+		std::string_view mappedView();
+
 		void trace();
 		string toString();
 		uInt64 getSize();
 	};
 
+	//reads a file or stdin front to back as lines or fixed size chunks, memory use is bounded by the longest line
+	//every item is read into the same buffer, nothing is allocated on the heap until the current item is requested
+	class ObjFileIterator : public Obj {
+	public:
+		//nullptr once everything has been read
+		std::FILE* source;
+		bool ownsSource;
+		//0 if the iterator yields lines
+		uInt64 chunkSize;
+		vector<char> buffer;
+		//bytes in [bufferStart, bufferEnd) have been read but not yet handed out
+		uInt64 bufferStart;
+		uInt64 bufferEnd;
+		bool reachedEOF;
+		//current item, points into 'buffer' and is only valid until the next call to advance
+		std::string_view current;
+
+		//reads from stdin if 'path' is empty, check 'source' to see if opening succeeded
+		ObjFileIterator(const string& path, uInt64 _chunkSize);
+		~ObjFileIterator();
+
+		//moves on to the next item, blocks if more has to be read, returns false once there is nothing left
+		//'thread' is the one waiting for the read, see runtime::Thread::waitForFd
+		bool advance(runtime::Thread* thread);
+		void close();
+
+		void trace();
+		string toString();
+		uInt64 getSize();
+	private:
+		//reads what's available after the unread bytes(at most what fits), growing the buffer if it's already full
+		void refill(runtime::Thread* thread);
+	};
+
 	//language representation of a mutex object
 	class ObjMutex : public Obj {
 		std::shared_mutex mtx;
@@ -215,4 +402,67 @@ namespace object {
 		string toString();
 		uInt64 getSize();
 	};
+
+	//multi producer multi consumer queue for passing values between threads
+	//bounded channels are a lock free ring buffer, their mutex is only used to block and to wake up blocked threads
+	//unbounded channels keep everything behind the mutex, which is uncontended most of the time
+	class ObjChannel : public Obj {
+	public:
+		//0 for unbounded channels
+		uInt64 capacity;
+		std::atomic<bool> closed;
+
+		ObjChannel(uInt64 _capacity);
+		~ObjChannel() {}
+
+		//never block, trySend fails if the channel is full and tryRecv if it's empty
+		bool trySend(Value val);
+		bool tryRecv(Value& val);
+		//block until the operation can be done, send fails if the channel is closed and recv fails once the channel is
+		//closed and everything sent before that has been received
+		bool send(runtime::Thread* thread, Value val);
+		bool recv(runtime::Thread* thread, Value& val);
+		//wakes up every blocked thread, closing a channel twice does nothing
+		void close();
+		//true if tryRecv would succeed, doesn't modify anything
+		bool canRecv();
+
+		void trace();
+		string toString();
+		uInt64 getSize();
+
+		//select waits on many channels at once, so every send and close notifies it's cond var if anyone is selecting
+		static std::mutex selectMtx;
+		static std::condition_variable selectCv;
+		static std::atomic<int> selectWaiters;
+	private:
+		struct Cell {
+			//equal to the position of the next send if the cell is free, or to that position + 1 once it's filled
+			std::atomic<uInt64> sequence;
+			Value val;
+		};
+		std::unique_ptr<Cell[]> cells;
+		std::atomic<uInt64> sendPos;
+		//keeps senders and receivers from invalidating each other's cache line
+		char padding[64];
+		std::atomic<uInt64> recvPos;
+
+		std::deque<Value> queue;
+		//size of 'queue' that can be read without holding the mutex
+		std::atomic<uInt64> queueSize;
+
+		std::mutex mtx;
+		std::condition_variable notEmpty;
+		std::condition_variable notFull;
+		std::atomic<int> waitingReceivers;
+		std::atomic<int> waitingSenders;
+
+		//unbounded channels must hold 'mtx' when calling these
+		bool push(Value val);
+		bool pop(Value& val);
+		bool canSend();
+		void notifyReceivers();
+		void notifySenders();
+		static void notifySelect();
+	};
 }
\ No newline at end of file
@@ -1,10 +1,9 @@
 #pragma once
 #pragma once
-#include "../moduleDefs.h"
+#include "../modulesDefs.h"
+#include <new>
 
 namespace AST {
-	using std::shared_ptr;
-
 	enum class ASTType {
 		ASSIGNMENT,
 		SET,
@@ -12,6 +11,7 @@ namespace AST {
 		BINARY,
 		UNARY,
 		ARRAY_LITERAL,
+		MAP_LITERAL,
 		CALL,
 		FIELD_ACCESS,
 		ASYNC,
@@ -46,6 +46,7 @@ namespace AST {
 	class BinaryExpr;
 	class UnaryExpr;
 	class ArrayLiteralExpr;
+	class MapLiteralExpr;
 	class CallExpr;
 	class FieldAccessExpr;
 	class AsyncExpr;
@@ -87,6 +88,7 @@ namespace AST {
 		virtual void visitAsyncExpr(AsyncExpr* expr) = 0;
 		virtual void visitAwaitExpr(AwaitExpr* expr) = 0;
 		virtual void visitArrayLiteralExpr(ArrayLiteralExpr* expr) = 0;
+		virtual void visitMapLiteralExpr(MapLiteralExpr* expr) = 0;
 		virtual void visitStructLiteralExpr(StructLiteral* expr) = 0;
 		virtual void visitLiteralExpr(LiteralExpr* expr) = 0;
 		virtual void visitSuperExpr(SuperExpr* expr) = 0;
@@ -119,7 +121,47 @@ namespace AST {
 		virtual ~ASTNode() {};
 		virtual void accept(Visitor* vis) = 0;
 	};
-	using ASTNodePtr = shared_ptr<ASTNode>;
+	//nodes are owned by the ASTArena of the module they were parsed in, pointers between nodes are non-owning
+	using ASTNodePtr = ASTNode*;
+
+	//bump allocator for the nodes of a single module, every node is freed at once when the arena is destroyed
+	//(when the module is deleted after codegen)
+	class ASTArena {
+	public:
+		ASTArena() = default;
+		ASTArena(const ASTArena&) = delete;
+		ASTArena& operator=(const ASTArena&) = delete;
+		~ASTArena() {
+			//nodes still own vectors of children/tokens, so their destructors have to run before the blocks are freed
+			for (ASTNode* node : nodes) node->~ASTNode();
+			for (byte* block : blocks) delete[] block;
+		}
+
+		template<typename T, typename... Args>
+		T* make(Args&&... args) {
+			T* node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			nodes.push_back(node);
+			return node;
+		}
+	private:
+		static constexpr uInt64 BLOCK_SIZE = 64 * 1024;
+		vector<byte*> blocks;
+		vector<ASTNode*> nodes;
+		//offset into the last block, starts out as full so that the first allocation creates a block
+		uInt64 used = BLOCK_SIZE;
+
+		void* allocate(uInt64 size, uInt64 align) {
+			used = (used + align - 1) & ~(align - 1);
+			if (used + size > BLOCK_SIZE) {
+				//new[] returns memory aligned for any fundamental type, which covers every node
+				blocks.push_back(new byte[BLOCK_SIZE]);
+				used = 0;
+			}
+			void* ptr = blocks.back() + used;
+			used += size;
+			return ptr;
+		}
+	};
 
 	class ASTDecl : public ASTNode {
 	public:
@@ -229,6 +271,30 @@ namespace AST {
 		}
 	};
 
+	struct MapEntry {
+		ASTNodePtr key;
+		ASTNodePtr val;
+		MapEntry(ASTNodePtr _key, ASTNodePtr _val) {
+			key = _key;
+			val = _val;
+		}
+	};
+
+	class MapLiteralExpr : public ASTNode {
+	public:
+		Token bracket;
+		vector<MapEntry> entries;
+
+		MapLiteralExpr(Token _bracket, vector<MapEntry>& _entries) {
+			bracket = _bracket;
+			entries = _entries;
+			type = ASTType::MAP_LITERAL;
+		}
+		void accept(Visitor* vis) override {
+			vis->visitMapLiteralExpr(this);
+		}
+	};
+
 	class CallExpr : public ASTNode {
 	public:
 		ASTNodePtr callee;
@@ -531,10 +597,10 @@ namespace AST {
 	class SwitchStmt : public ASTNode {
 	public:
 		ASTNodePtr expr;
-		vector<shared_ptr<CaseStmt>> cases;
+		vector<CaseStmt*> cases;
 		bool hasDefault;
 
-		SwitchStmt(ASTNodePtr _expr, vector<shared_ptr<CaseStmt>> _cases, bool _hasDefault) {
+		SwitchStmt(ASTNodePtr _expr, vector<CaseStmt*> _cases, bool _hasDefault) {
 			expr = _expr;
 			cases = _cases;
 			hasDefault = _hasDefault;
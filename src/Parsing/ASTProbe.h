@@ -17,6 +17,7 @@ namespace AST {
 		void visitAsyncExpr(AsyncExpr* expr);
 		void visitAwaitExpr(AwaitExpr* expr);
 		void visitArrayLiteralExpr(ArrayLiteralExpr* expr);
+		void visitMapLiteralExpr(MapLiteralExpr* expr);
 		void visitStructLiteralExpr(StructLiteral* expr);
 		void visitLiteralExpr(LiteralExpr* expr);
 		void visitFuncLiteral(FuncLiteral* expr);
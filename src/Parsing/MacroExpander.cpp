@@ -46,6 +46,12 @@ void AST::MacroExpander::visitArrayLiteralExpr(ArrayLiteralExpr* expr) {
         expand(member);
     }
 }
+void AST::MacroExpander::visitMapLiteralExpr(MapLiteralExpr* expr) {
+    for (const MapEntry& entry : expr->entries) {
+        expand(entry.key);
+        expand(entry.val);
+    }
+}
 void AST::MacroExpander::visitStructLiteralExpr(StructLiteral* expr) {
     for (const StructEntry& entry : expr->fields) {
         expand(entry.expr);
@@ -128,141 +134,230 @@ AST::Macro::Macro(Token _name, Parser* _parser) {
     parser = _parser;
 }
 
-AST::ASTNodePtr AST::Macro::expand(vector<Token>& args, const Token& callerToken) {
-    unordered_map<string, std::unique_ptr<exprMetaVar>> exprMetaVars;
-    unordered_map<string, std::unique_ptr<ttMetaVar>> ttMetaVars;
+// Hash of the types and lexemes of the argument tokens, used as the key of the match cache
+static uInt64 hashArgs(vector<Token>& args) {
+    uInt64 hash = 14695981039346656037ull;
+    for (const Token& token : args) {
+        hash = (hash ^ static_cast<byte>(token.type)) * 1099511628211ull;
+        hash = (hash ^ std::hash<std::string_view>()(token.getLexemeView())) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool sameArgs(const vector<Token>& a, const vector<Token>& b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); i++) {
+        if (!a[i].compare(b[i])) return false;
+    }
+    return true;
+}
+
+bool AST::Macro::match(vector<Token>& args, MacroMatch& result) {
+    uInt64 hash = hashArgs(args);
+    auto it = matchCache.find(hash);
+    if (it != matchCache.end() && sameArgs(it->second.args, args)) {
+        result = it->second.match;
+        matchers[result.matcher].parseCaptures(args, result.captures);
+        return true;
+    }
 
     // Attempt to match every macro matcher to arguments ...
-    for (const MatchPattern& matcher : matchers) {
-        exprMetaVars.clear();
-        ttMetaVars.clear();
+    for (int i = 0; i < matchers.size(); i++) {
+        if (matchers[i].interpret(args, result.captures)) {
+            result.matcher = i;
+            break;
+        }
+    }
+    // ... we found no appropriate matcher
+    if (result.matcher == -1) return false;
 
-        // Try to interpret arguments into meta variables
-        if (!matcher.interpret(args, exprMetaVars, ttMetaVars)) { continue; }
+    // On a hash collision the older entry is simply replaced
+    CachedMatch& entry = matchCache[hash];
+    entry.args = args;
+    entry.match = result;
+    for (MetaVarCapture& capture : entry.match.captures) capture.expr = nullptr;
+    return true;
+}
 
-        // Expand all loops and substitute all tt meta variables
+AST::ASTNodePtr AST::Macro::expand(vector<Token>& args, const Token& callerToken) {
+    MacroMatch result;
+    if (!match(args, result)) {
+        parser->error(callerToken, "Couldn't find an appropriate matcher for the given macro arguments.");
+        return nullptr;
+    }
 
-        // Convert tokens to (partial) AST
-        parser->parseMode = ParseMode::Macro;
+    // Expand all loops and substitute all tt meta variables
 
-        parser->parseMode = ParseMode::Standard;
-        // Substitute all expr meta variables
+    // Convert tokens to (partial) AST
+    parser->parseMode = ParseMode::Macro;
 
-        // Return AST
-    }
+    parser->parseMode = ParseMode::Standard;
+    // Substitute all expr meta variables
 
-    // ... we found no appropriate matcher
-    parser->error(callerToken, "Couldn't find an appropriate matcher for the given macro arguments.");
+    // Return AST
     return nullptr;
 }
 
-
-bool AST::MatchPattern::interpret(vector<Token>& args, unordered_map<string, std::unique_ptr<exprMetaVar>>& exprMetaVars, unordered_map<string, std::unique_ptr<ttMetaVar>>& ttMetaVars) const {
+// Matches by walking the argument tokens once, tracking every state of the automaton that can be reached at each
+// argument(epsilon transitions of splits are followed right away), expr and tt states skip straight to the end of
+// the expression or token tree that starts at the current argument
+bool AST::MatchPattern::interpret(vector<Token>& args, vector<MetaVarCapture>& captures) const {
+    vector<Token>* prevContainer = parser->currentContainer;
+    int prevPtr = parser->currentPtr;
     parser->currentContainer = &args;
 
-    auto isAtEnd = [&](int i) { return i >= args.size(); };
-
-    vector<vector<int>> dp(args.size() + 1, vector<int>(pattern.size() + 1));
-    vector<vector<Transition>> backTransitions(args.size() + 1, vector<Transition>(pattern.size() + 1));
-    dp[0][0] = 1;
+    const int argCount = args.size();
+    const int stateCount = states.size();
+    auto index = [&](int pos, int state) { return pos * stateCount + state; };
+
+    pathCounts.assign((argCount + 1) * stateCount, 0);
+    backSteps.assign((argCount + 1) * stateCount, Step());
+    exprEnds.assign(argCount, -2);
+    exprNodes.assign(argCount, nullptr);
+
+    // Counts are capped at 2 since we only care about whether a state is reachable unambiguously,
+    // this also makes sure that loops which can match nothing terminate
+    auto reach = [&](int fromPos, int fromState, int pos, int state) {
+        byte& count = pathCounts[index(pos, state)];
+        byte newCount = std::min(2, count + pathCounts[index(fromPos, fromState)]);
+        if (newCount == count) return;
+        if (count == 0) backSteps[index(pos, state)] = { fromPos, fromState };
+        count = newCount;
+        if (pos == fromPos) worklist.push_back(state);
+    };
 
-    for (int i = 0; i < args.size(); i++) {
-        std::queue<int> toProcess;
-        for (int j = 0; j < pattern.size(); j++) {
-            toProcess.push(j);
+    pathCounts[index(0, startState)] = 1;
+    for (int pos = 0; pos <= argCount; pos++) {
+        worklist.clear();
+        for (int state = 0; state < stateCount; state++) {
+            if (pathCounts[index(pos, state)] != 0) worklist.push_back(state);
         }
-        while (!toProcess.empty()) {
-            int j = toProcess.front(); toProcess.pop();
-            // We should only try and transition if this state can be reached unambiguously
-            if (dp[i][j] != 1) continue;
-            // Transitions
-            // Ignore loop parens
-            if (loopTypes[j] == LoopType::Paren) {
-                dp[i + 1][j + 1] += dp[i][j];
-                backTransitions[i + 1][j + 1] = Transition(i, j, TransitionType::None);
-                continue;
+        while (!worklist.empty()) {
+            int state = worklist.back(); worklist.pop_back();
+            const MatcherState& cur = states[state];
+            switch (cur.op) {
+            case MatcherOp::Split:
+                reach(pos, state, pos, cur.next);
+                reach(pos, state, pos, cur.alt);
+                break;
+            case MatcherOp::ConsumeToken:
+                if (pos < argCount && args[pos].type == cur.tokenType) reach(pos, state, pos + 1, cur.next);
+                break;
+            case MatcherOp::ConsumeExpr: {
+                int end = exprEnd(args, pos);
+                if (end > pos) reach(pos, state, end, cur.next);
+                break;
             }
-
-            // Regular token
-            if (pattern[j].type != TokenType::DOLLAR && loopTypes[j] == LoopType::None) {
-                if (pattern[j].type != args[i].type) continue;
-                dp[i + 1][j + 1] += dp[i][j];
-                backTransitions[i + 1][j + 1] = Transition(i, j, TransitionType::ConsumeToken);
+            case MatcherOp::ConsumeTT: {
+                int end = ttEnd(args, pos);
+                if (end > pos) reach(pos, state, end, cur.next);
+                break;
             }
-            // Looping expression or meta variable
-            else {
-                if (pattern[j].type == TokenType::DOLLAR) {
-                    // Meta variable
-                    if (pattern[j + 1].type == TokenType::IDENTIFIER) {
-                        // Token tree
-                        if (pattern[j + 3].type == TokenType::TT) {
-                            parser->currentPtr = i;
-                            try {
-                                parser->readTokenTree();
-                                dp[parser->currentPtr][j + 4] += dp[i][j];
-                                backTransitions[parser->currentPtr][j + 4] = Transition(i, j, TransitionType::ConsumeTT);
-                            }
-                            catch (ParserException& e) { continue; }
-                        }
-                        // Expression
-                        else {
-                            parser->currentPtr = i;
-                            try {
-                                parser->expression();
-                                dp[parser->currentPtr][j + 4] += dp[i][j];
-                                backTransitions[parser->currentPtr][j + 4] = Transition(i, j, TransitionType::ConsumeExpr);
-                            }
-                            catch (ParserException& e) { continue; }
-                        }
-                    }
-                    // Loop start
-                    else {
-                        // Start loop
-                        dp[i][j + 1] += dp[i][j];
-                        backTransitions[i][j + 1] = Transition(i, j, TransitionType::LoopBegin);
-                        toProcess.push(j + 1);
-                        // Ignore loop
-                        dp[i][loopJumps[j] + 1] += dp[i][j];
-                        backTransitions[i][loopJumps[j] + 1] = Transition(i, j, TransitionType::None);
-                        toProcess.push(loopJumps[j] + 1);
-                    }
-                }
-                // Loop end
-                else {
-                    // Repeat loop
-                    dp[i][loopJumps[j] + 1] += dp[i][j];
-                    backTransitions[i][loopJumps[j] + 1] = Transition(i, j, TransitionType::LoopIterate);
-                    toProcess.push(loopJumps[j] + 1);
-                    // Continue without repeating
-                    dp[i][j + 1] += dp[i][j];
-                    backTransitions[i][j + 1] = Transition(i, j, TransitionType::LoopEnd);
-                }
+            case MatcherOp::Accept: break;
             }
         }
     }
+    parser->currentContainer = prevContainer;
+    parser->currentPtr = prevPtr;
+
+    byte count = pathCounts[index(argCount, acceptState)];
     // Impossible to interpret arguments with this matcher pattern
-    if (dp[args.size()][pattern.size()] == 0) return false;
+    if (count == 0) return false;
 
     // Multiple interpretations of arguments possible
-    if (dp[args.size()][pattern.size()] > 1) {
+    if (count > 1) {
         // TODO: Make this error better
         throw parser->error(pattern[0], "Ambiguous arguments to macro, multiple interpretations possible.", true);
-        return false;
     }
 
-    // There is exactly 1 interpretation of arguments possible.
-    int i = args.size(), j = pattern.size();
-    vector<Transition> path;
-    while (i != 0 || j != 0) {
-        Transition t = backTransitions[i][j];
-        path.push_back(t);
-        i = t.argsPtr;
-        j = t.matcherPtr;
+    // There is exactly 1 interpretation of arguments possible, every step on it's path has a single predecessor
+    captures.clear();
+    int pos = argCount, state = acceptState;
+    while (pos != 0 || state != startState) {
+        Step step = backSteps[index(pos, state)];
+        const MatcherState& from = states[step.state];
+        if (from.op == MatcherOp::ConsumeExpr || from.op == MatcherOp::ConsumeTT) {
+            captures.emplace_back(from.metaVar, step.pos, pos, from.op == MatcherOp::ConsumeExpr ? exprNodes[step.pos] : nullptr);
+        }
+        pos = step.pos;
+        state = step.state;
     }
-    std::reverse(path.begin(), path.end());
+    std::reverse(captures.begin(), captures.end());
     return true;
 }
 
+// The arguments are identical to the ones the captures were found for, so every expression parses the same way again
+void AST::MatchPattern::parseCaptures(vector<Token>& args, vector<MetaVarCapture>& captures) const {
+    vector<Token>* prevContainer = parser->currentContainer;
+    int prevPtr = parser->currentPtr;
+    ParseMode prevMode = parser->parseMode;
+    parser->currentContainer = &args;
+    parser->parseMode = ParseMode::Matcher;
+    for (MetaVarCapture& capture : captures) {
+        if (metaVars[capture.metaVar].type != MetaVarType::Expr) continue;
+        parser->currentPtr = capture.begin;
+        try {
+            capture.expr = parser->expression();
+        }
+        catch (ParserException& e) {
+            capture.expr = nullptr;
+        }
+    }
+    parser->parseMode = prevMode;
+    parser->currentContainer = prevContainer;
+    parser->currentPtr = prevPtr;
+}
+
+// Parses at most one expression per starting argument, the node is kept around to be used as the capture
+int AST::MatchPattern::exprEnd(vector<Token>& args, int pos) const {
+    if (pos >= args.size()) return -1;
+    if (exprEnds[pos] != -2) return exprEnds[pos];
+
+    ParseMode prevMode = parser->parseMode;
+    parser->parseMode = ParseMode::Matcher;
+    parser->currentPtr = pos;
+    try {
+        exprNodes[pos] = parser->expression();
+        exprEnds[pos] = parser->currentPtr;
+    }
+    catch (ParserException& e) {
+        exprEnds[pos] = -1;
+    }
+    parser->parseMode = prevMode;
+    return exprEnds[pos];
+}
+
+// A token tree is either a single token or a group enclosed in matching (), [] or {}
+int AST::MatchPattern::ttEnd(vector<Token>& args, int pos) const {
+    if (pos >= args.size()) return -1;
+    auto closerOf = [](TokenType type) {
+        switch (type) {
+        case TokenType::LEFT_PAREN: return TokenType::RIGHT_PAREN;
+        case TokenType::LEFT_BRACE: return TokenType::RIGHT_BRACE;
+        case TokenType::LEFT_BRACKET: return TokenType::RIGHT_BRACKET;
+        default: return TokenType::NONE;
+        }
+    };
+    auto isCloser = [](TokenType type) {
+        return type == TokenType::RIGHT_PAREN || type == TokenType::RIGHT_BRACE || type == TokenType::RIGHT_BRACKET;
+    };
+
+    if (isCloser(args[pos].type)) return -1;
+    if (closerOf(args[pos].type) == TokenType::NONE) return pos + 1;
+
+    vector<TokenType> closers;
+    for (int i = pos; i < args.size(); i++) {
+        TokenType closer = closerOf(args[i].type);
+        if (closer != TokenType::NONE) closers.push_back(closer);
+        else if (isCloser(args[i].type)) {
+            if (closers.back() != args[i].type) return -1;
+            closers.pop_back();
+            if (closers.empty()) return i + 1;
+        }
+    }
+    return -1;
+}
+
 // Checks if matcher pattern contains properly written loops and meta variables.
 // Loops are also precalculated here.
 void AST::MatchPattern::checkAndPrecalculatePattern() {
@@ -344,3 +439,82 @@ void AST::MatchPattern::checkAndPrecalculatePattern() {
         }
     }
 }
+
+
+int AST::MatchPattern::addState(MatcherOp op) {
+    states.emplace_back(op);
+    return states.size() - 1;
+}
+
+// Builds the automaton back to front, starting from the accept state
+void AST::MatchPattern::compile() {
+    states.clear();
+    metaVars.clear();
+    acceptState = addState(MatcherOp::Accept);
+    startState = compileSequence(0, pattern.size(), acceptState);
+    // Meta variables were found last to first, number them in the order they appear in the pattern instead
+    std::reverse(metaVars.begin(), metaVars.end());
+    for (MatcherState& state : states) {
+        if (state.metaVar != -1) state.metaVar = metaVars.size() - 1 - state.metaVar;
+    }
+}
+
+// Compiles pattern[begin, end) into states that continue at 'next' once the whole range is matched,
+// returns the first state of the range
+int AST::MatchPattern::compileSequence(int begin, int end, int next) {
+    // Split the range into elements first since they have to be compiled in reverse
+    vector<std::pair<int, int>> elements;
+    for (int i = begin; i < end;) {
+        int elementEnd = i + 1;
+        if (pattern[i].type == TokenType::DOLLAR) {
+            // Meta variable: $ name : fragment
+            if (pattern[i + 1].type == TokenType::IDENTIFIER) elementEnd = i + 4;
+            // Loop: $( body ) delimiter? *
+            else {
+                if (loopJumps[i] == i) throw parser->error(pattern[i], "Unterminated macro loop.");
+                elementEnd = loopJumps[i] + 1;
+            }
+        }
+        elements.emplace_back(i, elementEnd);
+        i = elementEnd;
+    }
+
+    for (auto it = elements.rbegin(); it != elements.rend(); it++) {
+        auto [elemBegin, elemEnd] = *it;
+        int state;
+        if (pattern[elemBegin].type != TokenType::DOLLAR) {
+            state = addState(MatcherOp::ConsumeToken);
+            states[state].tokenType = pattern[elemBegin].type;
+            states[state].next = next;
+        }
+        else if (pattern[elemBegin + 1].type == TokenType::IDENTIFIER) {
+            bool isExpr = pattern[elemBegin + 3].type == TokenType::EXPR;
+            state = addState(isExpr ? MatcherOp::ConsumeExpr : MatcherOp::ConsumeTT);
+            states[state].metaVar = metaVars.size();
+            states[state].next = next;
+            metaVars.emplace_back(pattern[elemBegin + 1].getLexeme(), isExpr ? MetaVarType::Expr : MetaVarType::TT);
+        }
+        else {
+            int star = elemEnd - 1;
+            bool hasDelimiter = pattern[star - 1].type != TokenType::RIGHT_PAREN;
+            int closeParen = hasDelimiter ? star - 2 : star - 1;
+            // Either skip the loop, or match the body followed by another(optional) iteration
+            int repeat = addState(MatcherOp::Split);
+            states[repeat].alt = next;
+            int body = compileSequence(elemBegin + 2, closeParen, repeat);
+            if (hasDelimiter) {
+                // Iterations after the first one need to be preceded by the delimiter
+                int delimiter = addState(MatcherOp::ConsumeToken);
+                states[delimiter].tokenType = pattern[star - 1].type;
+                states[delimiter].next = body;
+                states[repeat].next = delimiter;
+            }
+            else states[repeat].next = body;
+            state = addState(MatcherOp::Split);
+            states[state].next = body;
+            states[state].alt = next;
+        }
+        next = state;
+    }
+    return next;
+}
@@ -3,52 +3,57 @@
 #include "parser.h"
 #include "../Includes/fmt/format.h"
 #include <map>
-#include <queue>
-#include <iterator>
 
 #define MACRO_RECURSION_DEPTH 128
 
 namespace AST {
     class Parser;
 
-    enum class TransitionType {
-        None,
-        ConsumeToken,
-        ConsumeExpr,
-        ConsumeTT,
-        LoopBegin,
-        LoopIterate,
-        LoopEnd
-    };
-
     enum class LoopType {
         None,
         Star,
         Paren
     };
 
-    struct Transition {
-        int matcherPtr = 0, argsPtr = 0;
-        TransitionType type = TransitionType::None;
+    enum class MetaVarType {
+        Expr,
+        TT
+    };
 
-        Transition() = default;
-        Transition(int _matcherPtr, int _argsPtr, TransitionType _type) {
-            matcherPtr = _matcherPtr;
-            argsPtr = _argsPtr;
-            type = _type;
-        }
+    struct MetaVariable {
+        string name;
+        MetaVarType type;
+
+        MetaVariable(string _name, MetaVarType _type) : name(_name), type(_type) {};
+    };
+
+    // States of the automaton a matcher pattern is compiled to
+    enum class MatcherOp {
+        ConsumeToken, // consumes a single token of type 'tokenType'
+        ConsumeExpr, // consumes an expression and captures it into 'metaVar'
+        ConsumeTT, // consumes a token tree and captures it into 'metaVar'
+        Split, // continues at both 'next' and 'alt' without consuming anything
+        Accept
     };
 
-    struct exprMetaVar {
-        std::map<vector<int>, ASTNodePtr> vals;
+    struct MatcherState {
+        MatcherOp op;
+        TokenType tokenType = TokenType::NONE;
+        int metaVar = -1;
+        int next = -1, alt = -1;
 
-        exprMetaVar() = default;
+        MatcherState(MatcherOp _op) : op(_op) {};
     };
 
-    struct ttMetaVar {
-        std::map<vector<int>, vector<Token>> vals;
+    // A single capture of a meta variable, 'begin' and 'end' index into the macro arguments
+    // Captures of all meta variables are kept in one vector in the order they were matched in
+    struct MetaVarCapture {
+        int metaVar;
+        int begin, end;
+        // Only set for expr meta variables
+        ASTNodePtr expr;
 
-        ttMetaVar() = default;
+        MetaVarCapture(int _metaVar, int _begin, int _end, ASTNodePtr _expr) : metaVar(_metaVar), begin(_begin), end(_end), expr(_expr) {};
     };
 
     class MatchPattern {
@@ -58,7 +63,28 @@ namespace AST {
         vector<LoopType> loopTypes; // marks start of loops with type of loop
         Parser* parser;
 
+        // Compiled once when the macro is defined, 'startState' is where matching begins
+        vector<MatcherState> states;
+        vector<MetaVariable> metaVars;
+        int startState, acceptState;
+
+        // Scratch space reused between invocations, a matcher is only ever used by the parser of a single module
+        struct Step {
+            int pos = -1, state = -1;
+        };
+        mutable vector<byte> pathCounts; // number of ways(capped at 2) to reach (argument, state)
+        mutable vector<Step> backSteps; // the first predecessor of (argument, state)
+        mutable vector<int> worklist;
+        mutable vector<int> exprEnds; // end of the expression starting at an argument, -2 if unknown and -1 if there is none
+        mutable vector<ASTNodePtr> exprNodes;
+
         void checkAndPrecalculatePattern();
+        void compile();
+        int compileSequence(int begin, int end, int next);
+        int addState(MatcherOp op);
+
+        int exprEnd(vector<Token>& args, int pos) const;
+        int ttEnd(vector<Token>& args, int pos) const;
 
     public:
         MatchPattern(vector<Token> _pattern, Parser* _parser) {
@@ -70,15 +96,35 @@ namespace AST {
                 loopJumps.push_back(i);
             }
             checkAndPrecalculatePattern();
+            compile();
         }
 
-        bool interpret(vector<Token>& args, unordered_map<string, std::unique_ptr<exprMetaVar>>& exprMetaVars, unordered_map<string, std::unique_ptr<ttMetaVar>>& ttMetaVars) const;
+        // Returns true and fills 'captures' if the pattern matches all of 'args'
+        bool interpret(vector<Token>& args, vector<MetaVarCapture>& captures) const;
+        // Parses the expr captures of a match found for identical arguments again, this time out of 'args'
+        void parseCaptures(vector<Token>& args, vector<MetaVarCapture>& captures) const;
+    };
+
+    // Result of matching the arguments of a macro invocation
+    struct MacroMatch {
+        int matcher = -1;
+        vector<MetaVarCapture> captures;
     };
 
     class Macro {
     private:
         Parser* parser;
         Token name;
+
+        // Identical invocations reuse the matcher and capture spans found for the first one, keyed by a hash of the
+        // argument tokens. AST nodes aren't cached, they would point into the tokens of the first invocation
+        struct CachedMatch {
+            vector<Token> args;
+            MacroMatch match;
+        };
+        unordered_map<uInt64, CachedMatch> matchCache;
+
+        bool match(vector<Token>& args, MacroMatch& result);
     public:
         vector<MatchPattern> matchers;
         vector<vector<Token>> transcribers;
@@ -111,6 +157,7 @@ namespace AST {
         void visitAsyncExpr(AsyncExpr* expr) override;
         void visitAwaitExpr(AwaitExpr* expr) override;
         void visitArrayLiteralExpr(ArrayLiteralExpr* expr) override;
+        void visitMapLiteralExpr(MapLiteralExpr* expr) override;
         void visitStructLiteralExpr(StructLiteral* expr) override;
         void visitLiteralExpr(LiteralExpr* expr) override;
         void visitFuncLiteral(FuncLiteral* expr) override;
@@ -2,8 +2,10 @@
 #include "../ErrorHandling/errorHandler.h"
 #include "../DebugPrinting/ASTPrinter.h"
 #include "../Includes/fmt/format.h"
+#include "../parallel.h"
+#include <algorithm>
+#include <unordered_set>
 
-using std::make_shared;
 using namespace AST;
 
 // Have to define this in the AST namespace because parselets are c++ friend classes
@@ -19,14 +21,14 @@ namespace AST {
 			ASTNodePtr expr = cur->expression(prec);
 			switch (token.type) {
 			case TokenType::AWAIT:
-				return make_shared<AwaitExpr>(token, expr);
+				return cur->make<AwaitExpr>(token, expr);
 			case TokenType::ASYNC: {
 				if (expr->type != ASTType::CALL) throw cur->error(token, "Expected a call after 'thread'.");
-				CallExpr* call = dynamic_cast<CallExpr*>(expr.get());
-				return make_shared<AsyncExpr>(token, call->callee, call->args);
+				CallExpr* call = dynamic_cast<CallExpr*>(expr);
+				return cur->make<AsyncExpr>(token, call->callee, call->args);
 			}
 			default:
-				return make_shared<UnaryExpr>(token, expr, true);
+				return cur->make<UnaryExpr>(token, expr, true);
 			}
 		}
 	};
@@ -44,7 +46,7 @@ namespace AST {
 			case TokenType::SUPER: {
 				cur->consume(TokenType::DOT, "Expected '.' after super.");
 				Token ident = cur->consume(TokenType::IDENTIFIER, "Expect superclass method name.");
-				return make_shared<SuperExpr>(ident);
+				return cur->make<SuperExpr>(ident);
 			}
 			case TokenType::LEFT_PAREN: {
 				//grouping can contain a expr of any precedence
@@ -52,16 +54,36 @@ namespace AST {
 				cur->consume(TokenType::RIGHT_PAREN, "Expected ')' at the end of grouping expression.");
 				return expr;
 			}
-									  //Array literal
+									  //Array or map literal
 			case TokenType::LEFT_BRACKET: {
+				//empty map: [:]
+				if (cur->match(TokenType::COLON)) {
+					vector<MapEntry> entries;
+					cur->consume(TokenType::RIGHT_BRACKET, "Expect ']' at the end of a map literal.");
+					return cur->make<MapLiteralExpr>(token, entries);
+				}
 				vector<ASTNodePtr> members;
 				if (cur->peek().type != TokenType::RIGHT_BRACKET) {
-					do {
+					ASTNodePtr first = cur->expression();
+					//a ':' after the first expression means this is a map literal: [key1 : val1, key2 : val2]
+					if (cur->match(TokenType::COLON)) {
+						vector<MapEntry> entries;
+						entries.emplace_back(first, cur->expression());
+						while (cur->match(TokenType::COMMA)) {
+							ASTNodePtr key = cur->expression();
+							cur->consume(TokenType::COLON, "Expected a ':' after map key.");
+							entries.emplace_back(key, cur->expression());
+						}
+						cur->consume(TokenType::RIGHT_BRACKET, "Expect ']' at the end of a map literal.");
+						return cur->make<MapLiteralExpr>(token, entries);
+					}
+					members.push_back(first);
+					while (cur->match(TokenType::COMMA)) {
 						members.push_back(cur->expression());
-					} while (cur->match(TokenType::COMMA));
+					}
 				}
 				cur->consume(TokenType::RIGHT_BRACKET, "Expect ']' at the end of an array literal.");
-				return make_shared<ArrayLiteralExpr>(members);
+				return cur->make<ArrayLiteralExpr>(members);
 			}
 										//Struct literal
 			case TokenType::LEFT_BRACE: {
@@ -76,7 +98,7 @@ namespace AST {
 					} while (cur->match(TokenType::COMMA));
 				}
 				cur->consume(TokenType::RIGHT_BRACE, "Expect '}' after struct literal.");
-				return make_shared<StructLiteral>(entries);
+				return cur->make<StructLiteral>(entries);
 			}
 									  //function literal
 			case TokenType::FUNC: {
@@ -105,11 +127,11 @@ namespace AST {
 
 				cur->loopDepth = tempLoopDepth;
 				cur->switchDepth = tempSwitchDepth;
-				return make_shared<FuncLiteral>(args, body);
+				return cur->make<FuncLiteral>(args, body);
 			}
 								//number, string, boolean or nil
 			default:
-				return make_shared<LiteralExpr>(token);
+				return cur->make<LiteralExpr>(token);
 			}
 		}
 	};
@@ -126,11 +148,12 @@ namespace AST {
 			if (left->type != ASTType::LITERAL) throw cur->error(token, "Left side is not assignable");
 
 			left->accept(cur->probe);
-			if (cur->probe->getProbedToken().type != TokenType::IDENTIFIER) throw cur->error(token, "Left side is not assignable");
+			Token name = cur->probe->getProbedToken();
+			if (name.type != TokenType::IDENTIFIER) throw cur->error(token, "Left side is not assignable");
 
-			//makes it right associative
+			//makes it right associative, the right side can use the probe again(eg. a = b[0]), so the name is read before
 			ASTNodePtr right = parseAssign(left, token);
-			return make_shared<AssignmentExpr>(cur->probe->getProbedToken(), right);
+			return cur->make<AssignmentExpr>(name, right);
 		}
 
 		//used for parsing assignment tokens(eg. =, +=, *=...)
@@ -141,35 +164,35 @@ namespace AST {
 				break;
 			}
 			case TokenType::PLUS_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::PLUS, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::PLUS, op), right);
 				break;
 			}
 			case TokenType::MINUS_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::MINUS, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::MINUS, op), right);
 				break;
 			}
 			case TokenType::SLASH_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::SLASH, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::SLASH, op), right);
 				break;
 			}
 			case TokenType::STAR_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::STAR, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::STAR, op), right);
 				break;
 			}
 			case TokenType::BITWISE_XOR_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::BITWISE_XOR, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::BITWISE_XOR, op), right);
 				break;
 			}
 			case TokenType::BITWISE_AND_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::BITWISE_AND, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::BITWISE_AND, op), right);
 				break;
 			}
 			case TokenType::BITWISE_OR_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::BITWISE_OR, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::BITWISE_OR, op), right);
 				break;
 			}
 			case TokenType::PERCENTAGE_EQUAL: {
-				right = make_shared<BinaryExpr>(left, Token(TokenType::PERCENTAGE, op), right);
+				right = cur->make<BinaryExpr>(left, Token(TokenType::PERCENTAGE, op), right);
 				break;
 			}
 			}
@@ -188,7 +211,7 @@ namespace AST {
 			ASTNodePtr thenBranch = cur->expression(prec - 1);
 			cur->consume(TokenType::COLON, "Expected ':' after then branch.");
 			ASTNodePtr elseBranch = cur->expression(prec - 1);
-			return make_shared<ConditionalExpr>(left, thenBranch, elseBranch);
+			return cur->make<ConditionalExpr>(left, thenBranch, elseBranch);
 		}
 	};
 
@@ -205,7 +228,7 @@ namespace AST {
 				if (left->type == ASTType::LITERAL) {
 					left->accept(cur->probe);
 					Token ident = cur->consume(TokenType::IDENTIFIER, "Expected variable name.");
-					return make_shared<ModuleAccessExpr>(cur->probe->getProbedToken(), ident);
+					return cur->make<ModuleAccessExpr>(cur->probe->getProbedToken(), ident);
 				}
 				else throw cur->error(token, "Expected module name identifier.");
 			}
@@ -221,13 +244,13 @@ namespace AST {
 					if (!cur->macros.contains(macroName.getLexeme())) {
 						throw cur->error(macroName, "Invoked macro isn't defined");
 					}
-					return make_shared<MacroExpr>(macroName, cur->readTokenTree());
+					return cur->make<MacroExpr>(macroName, cur->readTokenTree());
 				}
 				throw cur->error(token, "Expected macro name to be an identifier.");
 			}
 
 			ASTNodePtr right = cur->expression(prec);
-			return make_shared<BinaryExpr>(left, token, right);
+			return cur->make<BinaryExpr>(left, token, right);
 		}
 	};
 
@@ -239,7 +262,7 @@ namespace AST {
 			prec = _prec;
 		}
 		ASTNodePtr parse(ASTNodePtr var, Token op, int surroundingPrec) {
-			return make_shared<UnaryExpr>(op, var, false);
+			return cur->make<UnaryExpr>(op, var, false);
 		}
 	};
 
@@ -258,7 +281,7 @@ namespace AST {
 				} while (cur->match(TokenType::COMMA));
 			}
 			cur->consume(TokenType::RIGHT_PAREN, "Expect ')' after call expression.");
-			return make_shared<CallExpr>(left, args);
+			return cur->make<CallExpr>(left, args);
 		}
 	};
 
@@ -274,7 +297,7 @@ namespace AST {
 			Token newToken = token;
 			if (token.type == TokenType::LEFT_BRACKET) {//array/struct with string access
 				field = cur->expression();
-				//object["field"] gets optimized to object.field
+				//object["field"] gets optimized to object.field, property access on maps looks up the key
 				if (field->type == ASTType::LITERAL) {
 					field->accept(cur->probe);
 					if (cur->probe->getProbedToken().type == TokenType::STRING) newToken.type = TokenType::DOT;
@@ -283,7 +306,7 @@ namespace AST {
 			}
 			else if (token.type == TokenType::DOT) {//struct/object access
 				Token fieldName = cur->consume(TokenType::IDENTIFIER, "Expected a field identifier.");
-				field = make_shared<LiteralExpr>(fieldName);
+				field = cur->make<LiteralExpr>(fieldName);
 			}
 			//if we have something like arr[0] = 1 or struct.field = 1 we can't parse it with the assignment expr
 			//this handles that case and produces a special set expr
@@ -295,9 +318,9 @@ namespace AST {
 					TokenType::BITWISE_OR_EQUAL, TokenType::PERCENTAGE_EQUAL })) {
 				Token op = cur->previous();
 				ASTNodePtr val = cur->expression();
-				return make_shared<SetExpr>(left, field, newToken, op, val);
+				return cur->make<SetExpr>(left, field, newToken, op, val);
 			}
-			return make_shared<FieldAccessExpr>(left, newToken, field);
+			return cur->make<FieldAccessExpr>(left, newToken, field);
 		}
 	};
 
@@ -391,37 +414,59 @@ Parser::Parser() {
 #pragma endregion
 }
 
+Parser::~Parser() {
+	delete probe;
+	delete macroExpander;
+}
+
 void Parser::parse(vector<CSLModule*>& modules) {
-#ifdef AST_DEBUG
-	ASTPrinter printer;
-#endif
-	//modules are already sorted using toposort
+	//modules don't depend on each other's AST, so each one is parsed on it's own by a separate parser
+	//errors are buffered per module and reported in the same order as if the modules were parsed one after another
+	//modules kept from a previous build(watch mode) already have an AST and aren't parsed again
+	vector<CSLModule*> toParse;
+	for (CSLModule* unit : modules) {
+		if (!unit->astArena) toParse.push_back(unit);
+	}
+	//a macro is visible in every module that comes after the one defining it, macros can only be defined at the top level
+	//so their definitions are found by a quick scan over the tokens, each parser then replays the ones it uses
+	MacroSites macroSites;
+	unordered_map<CSLModule*, uInt> visibleSites;
 	for (CSLModule* unit : modules) {
-		parsedUnit = unit;
-
-		// Parse tokenized source into AST
-		loopDepth = 0;
-		switchDepth = 0;
-		currentContainer = &parsedUnit->tokens;
-		currentPtr = 0;
-		while (!isAtEnd()) {
-			try {
-				if (match(TokenType::ADDMACRO)) {
-					defineMacro();
-					continue;
+		visibleSites[unit] = macroSites.sites.size();
+		vector<Token>& tokens = unit->tokens;
+		int braceDepth = 0;
+		for (int i = 0; i < tokens.size(); i++) {
+			TokenType type = tokens[i].type;
+			if (type == TokenType::LEFT_BRACE) braceDepth++;
+			else if (type == TokenType::RIGHT_BRACE) braceDepth--;
+			else if (type == TokenType::ADDMACRO && braceDepth == 0) {
+				int end = i + 1, depth = 0;
+				for (; end < tokens.size(); end++) {
+					if (tokens[end].type == TokenType::LEFT_BRACE) depth++;
+					else if (tokens[end].type == TokenType::RIGHT_BRACE && --depth == 0) break;
 				}
-				unit->stmts.push_back(topLevelDeclaration());
-#ifdef AST_DEBUG
-				//prints statement
-				unit->stmts[unit->stmts.size() - 1]->accept(&printer);
-#endif
-			}
-			catch (ParserException& e) {
-				sync();
+				end = std::min(end + 1, static_cast<int>(tokens.size()));
+				//a malformed header fails before defining anything, so it can't be visible in other modules
+				if (i + 3 < tokens.size() && tokens[i + 1].type == TokenType::BANG && tokens[i + 2].type == TokenType::IDENTIFIER
+					&& tokens[i + 3].type == TokenType::LEFT_BRACE) {
+					macroSites.byName[tokens[i + 2].getLexeme()].push_back(macroSites.sites.size());
+				}
+				macroSites.sites.push_back(MacroSite{ unit, i, end });
 			}
 		}
-
-		expandMacros();
+	}
+	parallelFor(toParse.size(), [&](uInt i) {
+		errorHandler::ErrorBufferGuard buffer(i);
+		Parser parser;
+		parser.importMacros(macroSites, visibleSites.at(toParse[i]), toParse[i]->tokens);
+		parser.parseModule(toParse[i]);
+	});
+	errorHandler::flushErrorBuffers();
+	if (debugFlags::printAST) {
+		ASTPrinter printer;
+		for (CSLModule* unit : toParse) {
+			for (ASTNodePtr stmt : unit->stmts) stmt->accept(&printer);
+		}
 	}
 	//look at each unit and determine if any of its dependencies that are imported without an alias are exporting the same symbol,
 	//or if 2 or more units using aliases share the same alias, which is forbidden
@@ -457,6 +502,68 @@ void Parser::parse(vector<CSLModule*>& modules) {
 	}
 }
 
+void Parser::parseModule(CSLModule* unit) {
+	parsedUnit = unit;
+	parsedUnit->astArena = std::make_unique<ASTArena>();
+
+	// Parse tokenized source into AST
+	loopDepth = 0;
+	switchDepth = 0;
+	currentContainer = &parsedUnit->tokens;
+	currentPtr = 0;
+	while (!isAtEnd()) {
+		try {
+			if (match(TokenType::ADDMACRO)) {
+				defineMacro();
+				continue;
+			}
+			unit->stmts.push_back(topLevelDeclaration());
+		}
+		catch (ParserException& e) {
+			sync();
+		}
+	}
+
+	expandMacros();
+}
+
+//replaying every visible definition costs O(modules * macros), so only the last definition of each macro the module invokes
+//is replayed, earlier ones would be overwritten by it anyway. Macros invoked by a replayed definition are imported too
+void Parser::importMacros(const MacroSites& macroSites, uInt count, const vector<Token>& tokens) {
+	vector<uInt> toDefine;
+	std::unordered_set<string> invoked;
+	auto findInvocations = [&](const vector<Token>& container, int begin, int end) {
+		for (int i = begin; i + 1 < end; i++) {
+			if (container[i].type != TokenType::IDENTIFIER || container[i + 1].type != TokenType::BANG) continue;
+			string name = container[i].getLexeme();
+			if (!invoked.insert(name).second) continue;
+			auto it = macroSites.byName.find(name);
+			if (it == macroSites.byName.end()) continue;
+			//site indices are sorted, the last one before 'count' is the definition visible to this module
+			auto visibleEnd = std::lower_bound(it->second.begin(), it->second.end(), count);
+			if (visibleEnd != it->second.begin()) toDefine.push_back(*(visibleEnd - 1));
+		}
+	};
+	findInvocations(tokens, 0, tokens.size());
+	for (uInt i = 0; i < toDefine.size(); i++) {
+		const MacroSite& site = macroSites.sites[toDefine[i]];
+		findInvocations(site.unit->tokens, site.pos, site.end);
+	}
+
+	parseMode = ParseMode::MacroImport;
+	for (uInt index : toDefine) {
+		currentContainer = &macroSites.sites[index].unit->tokens;
+		currentPtr = macroSites.sites[index].pos + 1;
+		try {
+			defineMacro();
+		}
+		catch (ParserException& e) {
+			//the module that defines the macro reports the error, and ends up with the same partial definition
+		}
+	}
+	parseMode = ParseMode::Standard;
+}
+
 void Parser::defineMacro() {
 	consume(TokenType::BANG, "Expected '!' after 'addMacro' token.");
 	Token macroName = consume(TokenType::IDENTIFIER, "Expected macro name to be an identifier.");
@@ -503,7 +610,7 @@ ASTNodePtr Parser::expression(int prec) {
 		throw error(token, "Expected expression.");
 	}
 	unique_ptr<PrefixParselet>& prefix = prefixParselets[token.type];
-	shared_ptr<ASTNode> left = prefix->parse(token);
+	ASTNode* left = prefix->parse(token);
 
 	//advances only if the next token has a higher precedence than the parserCurrent one
 	//e.g. 1 + 2 compiles because the base precedence is 0, and '+' has a precedence of 11
@@ -529,7 +636,7 @@ ASTNodePtr Parser::topLevelDeclaration() {
 	//export is only allowed in global scope
 	if (match(TokenType::EXPORT)) {
 		//after export only keywords allowed are: var, class, func
-		shared_ptr<ASTDecl> node = nullptr;
+		ASTDecl* node = nullptr;
 		if (match(TokenType::VAR)) node = varDecl();
 		else if (match(TokenType::CLASS)) node = classDecl();
 		else if (match(TokenType::FUNC)) node = funcDecl();
@@ -547,7 +654,7 @@ ASTNodePtr Parser::topLevelDeclaration() {
 	}
 	else {
 		//top level declarations get put in a list for later loopup during compilation
-		shared_ptr<ASTDecl> node = nullptr;
+		ASTDecl* node = nullptr;
 		if (match(TokenType::VAR)) node = varDecl();
 		else if (match(TokenType::CLASS)) node = classDecl();
 		else if (match(TokenType::FUNC)) node = funcDecl();
@@ -564,7 +671,7 @@ ASTNodePtr Parser::localDeclaration() {
 	return statement();
 }
 
-shared_ptr<ASTDecl> Parser::varDecl() {
+ASTDecl* Parser::varDecl() {
 	Token name = consume(TokenType::IDENTIFIER, "Expected a variable identifier.");
 	ASTNodePtr expr = nullptr;
 	//if no initializer is present the variable is initialized to null
@@ -572,10 +679,10 @@ shared_ptr<ASTDecl> Parser::varDecl() {
 		expr = expression();
 	}
 	consume(TokenType::SEMICOLON, "Expected a ';' after variable declaration.");
-	return make_shared<VarDecl>(name, expr);
+	return make<VarDecl>(name, expr);
 }
 
-shared_ptr<ASTDecl> Parser::funcDecl() {
+ASTDecl* Parser::funcDecl() {
 	//the depths are used for throwing errors for switch and loops stmts, 
 	//and since a function can be declared inside a loop we need to account for that
 	int tempLoopDepth = loopDepth;
@@ -602,10 +709,10 @@ shared_ptr<ASTDecl> Parser::funcDecl() {
 
 	loopDepth = tempLoopDepth;
 	switchDepth = tempSwitchDepth;
-	return make_shared<FuncDecl>(name, args, body);
+	return make<FuncDecl>(name, args, body);
 }
 
-shared_ptr<ASTDecl> Parser::classDecl() {
+ASTDecl* Parser::classDecl() {
 	Token name = consume(TokenType::IDENTIFIER, "Expected a class name.");
 	ASTNodePtr inherited = nullptr;
 	//inheritance is optional
@@ -614,7 +721,7 @@ shared_ptr<ASTDecl> Parser::classDecl() {
 		//only accept identifiers and module access
 		inherited = expression();
 		if (!((inherited->type == ASTType::LITERAL
-			&& dynamic_cast<LiteralExpr*>(inherited.get())->token.type == TokenType::IDENTIFIER)
+			&& dynamic_cast<LiteralExpr*>(inherited)->token.type == TokenType::IDENTIFIER)
 			|| inherited->type == ASTType::MODULE_ACCESS)) {
 			error(token, "Superclass can only be an identifier.");
 		}
@@ -627,7 +734,7 @@ shared_ptr<ASTDecl> Parser::classDecl() {
 		methods.push_back(funcDecl());
 	}
 	consume(TokenType::RIGHT_BRACE, "Expect '}' after class body.");
-	return make_shared<ClassDecl>(name, methods, inherited, inherited != nullptr);
+	return make<ClassDecl>(name, methods, inherited, inherited != nullptr);
 }
 
 ASTNodePtr Parser::statement() {
@@ -655,13 +762,13 @@ ASTNodePtr Parser::statement() {
 ASTNodePtr Parser::printStmt() {
 	ASTNodePtr expr = expression();
 	consume(TokenType::SEMICOLON, "Expected ';' after expression.");
-	return make_shared<PrintStmt>(expr);
+	return make<PrintStmt>(expr);
 }
 
 ASTNodePtr Parser::exprStmt() {
 	ASTNodePtr expr = expression();
 	consume(TokenType::SEMICOLON, "Expected ';' after expression.");
-	return make_shared<ExprStmt>(expr);
+	return make<ExprStmt>(expr);
 }
 
 ASTNodePtr Parser::blockStmt() {
@@ -671,7 +778,7 @@ ASTNodePtr Parser::blockStmt() {
 		stmts.push_back(localDeclaration());
 	}
 	consume(TokenType::RIGHT_BRACE, "Expect '}' after block.");
-	return make_shared<BlockStmt>(stmts);
+	return make<BlockStmt>(stmts);
 }
 
 ASTNodePtr Parser::ifStmt() {
@@ -685,7 +792,7 @@ ASTNodePtr Parser::ifStmt() {
 	if (match(TokenType::ELSE)) {
 		elseBranch = statement();
 	}
-	return make_shared<IfStmt>(thenBranch, elseBranch, condition);
+	return make<IfStmt>(thenBranch, elseBranch, condition);
 }
 
 ASTNodePtr Parser::whileStmt() {
@@ -696,7 +803,7 @@ ASTNodePtr Parser::whileStmt() {
 	consume(TokenType::RIGHT_PAREN, "Expect ')' after condition.");
 	ASTNodePtr body = statement();
 	loopDepth--;
-	return make_shared<WhileStmt>(body, condition);
+	return make<WhileStmt>(body, condition);
 }
 
 ASTNodePtr Parser::forStmt() {
@@ -722,19 +829,19 @@ ASTNodePtr Parser::forStmt() {
 	//disallows declarations unless they're in a block
 	ASTNodePtr body = statement();
 	loopDepth--;
-	return make_shared<ForStmt>(init, condition, increment, body);
+	return make<ForStmt>(init, condition, increment, body);
 }
 
 ASTNodePtr Parser::breakStmt() {
 	if (loopDepth == 0 && switchDepth == 0) throw error(previous(), "Cannot use 'break' outside of loops or switch statements.");
 	consume(TokenType::SEMICOLON, "Expect ';' after break.");
-	return make_shared<BreakStmt>(previous());
+	return make<BreakStmt>(previous());
 }
 
 ASTNodePtr Parser::continueStmt() {
 	if (loopDepth == 0) throw error(previous(), "Cannot use 'continue' outside of loops.");
 	consume(TokenType::SEMICOLON, "Expect ';' after continue.");
-	return make_shared<ContinueStmt>(previous());
+	return make<ContinueStmt>(previous());
 }
 
 ASTNodePtr Parser::switchStmt() {
@@ -747,12 +854,12 @@ ASTNodePtr Parser::switchStmt() {
 	consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
 	consume(TokenType::LEFT_BRACE, "Expect '{' after switch expression.");
 	switchDepth++;
-	vector<shared_ptr<CaseStmt>> cases;
+	vector<CaseStmt*> cases;
 	bool hasDefault = false;
 
 	while (!check(TokenType::RIGHT_BRACE) && match({ TokenType::CASE, TokenType::DEFAULT })) {
 		Token prev = previous();//to see if it's a default statement
-		shared_ptr<CaseStmt> curCase = caseStmt();
+		CaseStmt* curCase = caseStmt();
 		curCase->caseType = prev;
 		if (prev.type == TokenType::DEFAULT) {
 			//don't throw, it isn't a breaking error
@@ -763,10 +870,10 @@ ASTNodePtr Parser::switchStmt() {
 	}
 	consume(TokenType::RIGHT_BRACE, "Expect '}' after switch body.");
 	switchDepth--;
-	return make_shared<SwitchStmt>(expr, cases, hasDefault);
+	return make<SwitchStmt>(expr, cases, hasDefault);
 }
 
-shared_ptr<CaseStmt> Parser::caseStmt() {
+CaseStmt* Parser::caseStmt() {
 	vector<Token> matchConstants;
 	//default cases don't have a match expression
 	if (previous().type != TokenType::DEFAULT) {
@@ -783,13 +890,13 @@ shared_ptr<CaseStmt> Parser::caseStmt() {
 	while (!check(TokenType::CASE) && !check(TokenType::RIGHT_BRACE) && !check(TokenType::DEFAULT)) {
 		stmts.push_back(localDeclaration());
 	}
-	return make_shared<CaseStmt>(matchConstants, stmts);
+	return make<CaseStmt>(matchConstants, stmts);
 }
 
 ASTNodePtr Parser::advanceStmt() {
 	if (switchDepth == 0) throw error(previous(), "Cannot use 'advance' outside of switch statements.");
 	consume(TokenType::SEMICOLON, "Expect ';' after 'advance'.");
-	return make_shared<AdvanceStmt>(previous());
+	return make<AdvanceStmt>(previous());
 }
 
 ASTNodePtr Parser::returnStmt() {
@@ -799,7 +906,7 @@ ASTNodePtr Parser::returnStmt() {
 		expr = expression();
 		consume(TokenType::SEMICOLON, "Expect ';' at the end of 'return'.");
 	}
-	return make_shared<ReturnStmt>(expr, keyword);
+	return make<ReturnStmt>(expr, keyword);
 }
 
 #pragma endregion
@@ -859,7 +966,9 @@ Token Parser::consume(TokenType type, string msg) {
 	throw error(peek(), msg);
 }
 
-ParserException Parser::error(Token token, string msg, bool ignoreParseMode) {
+ParserException Parser::error(const Token& token, string msg, bool ignoreParseMode) {
+	//replayed definitions are reported by the module they're defined in, even errors that ignore the parse mode
+	if (parseMode == ParseMode::MacroImport) return ParserException();
 	if (parseMode == ParseMode::Standard || ignoreParseMode) {
 		errorHandler::addCompileError(msg, token);
 	}
@@ -874,9 +983,8 @@ vector<Token> Parser::readTokenTree()
 
 	vector<Token> tokenTree = { previous() };
 
-	Token curToken;
+	Token curToken = previous();
 	while (parenCount > 0) {
-		std::cout << curToken.getLexeme() << " ";
 		if (isAtEnd()) {
 			throw error(curToken, "Unexpected end of file.");
 		}
@@ -890,15 +998,14 @@ vector<Token> Parser::readTokenTree()
 		if (check(TokenType::RIGHT_BRACKET)) { bracketCount--; }
 
 		curToken = advance();
+		tokenTree.push_back(curToken);
 
 		// Check for invalid token tree
 		if (braceCount < 0) throw error(curToken, "Unexpected '}' in token tree.");
 		if (bracketCount < 0) throw error(curToken, "Unexpected ']' in token tree.");
-
-		std::cout << "\n" << parenCount << " " << braceCount << " " << bracketCount << "\n";
 	}
 
-	if (braceCount >= 0 || bracketCount >= 0) {
+	if (braceCount != 0 || bracketCount != 0) {
 		throw error(curToken, "Unexpected early termination of token tree.");
 	}
 
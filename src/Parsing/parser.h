@@ -57,12 +57,28 @@ namespace AST {
 	enum class ParseMode {
 		Standard,
 		Macro,
-		Matcher
+		Matcher,
+		// Replaying macro definitions of another module, errors are reported by that module's parser
+		MacroImport
+	};
+
+	// Position of an 'addMacro' token at the top level of a module, 'end' is one past the closing brace of the definition
+	struct MacroSite {
+		CSLModule* unit;
+		int pos;
+		int end;
+	};
+
+	// Top level macro definitions of all modules in import order, along with the sites defining each macro name
+	struct MacroSites {
+		vector<MacroSite> sites;
+		unordered_map<string, vector<uInt>> byName;
 	};
 
 	class Parser {
 	public:
 		Parser();
+		~Parser();
 		void parse(vector<CSLModule*>& modules);
 
 	private:
@@ -89,7 +105,16 @@ namespace AST {
 		template<typename ParsletType>
 		void addInfix(TokenType type, Precedence prec);
 
+		// Nodes are allocated in the arena of the module being parsed and live until the module is deleted
+		template<typename T, typename... Args>
+		T* make(Args&&... args) {
+			return parsedUnit->astArena->make<T>(std::forward<Args>(args)...);
+		}
+
+		void parseModule(CSLModule* unit);
 		void defineMacro();
+		// Defines the macros 'tokens' invokes, as they're defined by the first 'count' sites
+		void importMacros(const MacroSites& macroSites, uInt count, const vector<Token>& tokens);
 
 #pragma region Expressions
 		ASTNodePtr expression(int prec);
@@ -119,9 +144,9 @@ namespace AST {
 #pragma region Statements
 		ASTNodePtr topLevelDeclaration();
 		ASTNodePtr localDeclaration();
-		shared_ptr<ASTDecl> varDecl();
-		shared_ptr<ASTDecl> funcDecl();
-		shared_ptr<ASTDecl> classDecl();
+		ASTDecl* varDecl();
+		ASTDecl* funcDecl();
+		ASTDecl* classDecl();
 
 		ASTNodePtr statement();
 		ASTNodePtr printStmt();
@@ -133,7 +158,7 @@ namespace AST {
 		ASTNodePtr breakStmt();
 		ASTNodePtr continueStmt();
 		ASTNodePtr switchStmt();
-		shared_ptr<CaseStmt> caseStmt();
+		CaseStmt* caseStmt();
 		ASTNodePtr advanceStmt();
 		ASTNodePtr returnStmt();
 
@@ -159,7 +184,7 @@ namespace AST {
 
 		Token consume(TokenType type, string msg);
 
-		ParserException error(Token token, string msg, bool ignoreParseMode = false);
+		ParserException error(const Token& token, string msg, bool ignoreParseMode = false);
 
 		vector<Token> readTokenTree();
 
@@ -3,6 +3,9 @@
 #include "../files.h"
 #include <iostream>
 #include "../ErrorHandling/errorHandler.h"
+#include "../parallel.h"
+#include "../phaseStats.h"
+#include <fstream>
 
 
 using std::unordered_set;
@@ -18,18 +21,29 @@ bool isAtEnd(const vector<Token>& tokens, const int pos) {
 
 bool match(TokenType type, const vector<Token>& tokens, const int pos) {
     if (pos < 0 || isAtEnd(tokens, pos)) return false;
-    return true;
+    return tokens[pos].type == type;
 }
 
-Preprocessor::Preprocessor() {
+Preprocessor::Preprocessor(bool _keepUnits) {
     projectRootPath = "";
-    curUnit = nullptr;
+    keepUnits = _keepUnits;
 }
 
 Preprocessor::~Preprocessor() {
+    if (keepUnits) releaseUnits();
 }
 
-void Preprocessor::preprocessProject(string mainFilePath) {
+void Preprocessor::releaseUnits() {
+    for (auto& [name, unit] : allUnits) {
+        delete unit->file;
+        delete unit;
+    }
+    allUnits.clear();
+    unitDirectives.clear();
+    records.clear();
+}
+
+void Preprocessor::preprocessProject(string mainFilePath, PhaseStats* stats) {
     path p(mainFilePath);
 
     // Check file validity
@@ -39,38 +53,266 @@ void Preprocessor::preprocessProject(string mainFilePath) {
     }
 
     projectRootPath = p.parent_path().string() + "/";
-    CSLModule* mainModule = scanFile("main.csl");
+    // Everything except the graph of the last successful build(and kept modules) is recomputed
+    if (keepUnits) {
+        keptUnits = std::move(allUnits);
+        keptRecords = std::move(records);
+        keptDirectives = std::move(unitDirectives);
+    }
+    allUnits.clear();
+    unitDirectives.clear();
+    visitedUnits.clear();
+    sortedUnits.clear();
+    records.clear();
+    dirtyUnits.clear();
+    if (prevRecords.empty()) loadImportGraph();
+
+    if (stats) stats->begin("scanning");
+    scanProject("main.csl");
+    if (stats) {
+        uInt64 bytes = 0;
+        for (auto& [name, unit] : allUnits) {
+            // Kept modules weren't scanned again
+            auto kept = keptUnits.find(name);
+            if (kept == keptUnits.end() || kept->second != unit) bytes += unit->file->sourceFile.size();
+        }
+        stats->addBytes(bytes);
+        stats->begin("preprocessing");
+    }
+    CSLModule* mainModule = allUnits["main.csl"];
+    resolveDependencies(mainModule);
     toposort(mainModule);
+    markDirtyUnits();
+
+    // Kept modules that were rescanned or are no longer imported by anything
+    for (auto& [name, unit] : keptUnits) {
+        auto it = allUnits.find(name);
+        if (it != allUnits.end() && it->second == unit) continue;
+        delete unit->file;
+        delete unit;
+    }
+    keptUnits.clear();
+    keptRecords.clear();
+    keptDirectives.clear();
+}
+
+vector<CSLModule*> Preprocessor::getDirtyUnits() {
+    vector<CSLModule*> dirty;
+    for (CSLModule* unit : sortedUnits) {
+        if (dirtyUnits.contains(unit)) dirty.push_back(unit);
+    }
+    return dirty;
+}
+
+// Extracts the module name from the string token of an import
+static string dependencyName(Token& path) {
+    string depName = path.getLexeme();
+    return depName.substr(1, depName.size() - 2);
+}
+
+// Scans every module reachable from main.csl, breadth first
+// Modules discovered in the same step don't depend on each other's tokens, so they are all scanned in parallel
+void Preprocessor::scanProject(string mainModuleName) {
+    vector<string> frontier = { mainModuleName };
+    unordered_set<string> discovered = { mainModuleName };
+    uInt errorBuffer = 0;
+
+    while (!frontier.empty()) {
+        vector<CSLModule*> scanned(frontier.size());
+        vector<vector<pair<Token, Token>>> directives(frontier.size());
+        vector<ModuleRecord> fileRecords(frontier.size());
+        uInt firstBuffer = errorBuffer;
+        errorBuffer += frontier.size();
+
+        parallelFor(frontier.size(), [&](uInt i) {
+            errorHandler::ErrorBufferGuard buffer(firstBuffer + i);
+            if (CSLModule* kept = findKeptUnit(frontier[i])) {
+                scanned[i] = kept;
+                directives[i] = keptDirectives.at(kept);
+                fileRecords[i] = keptRecords.at(frontier[i]);
+                fileRecords[i].deps.clear();
+            }
+            else {
+                Scanner scanner;
+                scanned[i] = scanFile(frontier[i], scanner);
+                directives[i] = retrieveDirectives(scanned[i]);
+                fileRecords[i] = recordFile(frontier[i], scanned[i]->file->sourceFile);
+            }
+        });
+
+        vector<string> next;
+        for (uInt i = 0; i < frontier.size(); i++) {
+            allUnits[frontier[i]] = scanned[i];
+            // Imports of kept modules are linked again, since the modules they point to might have been rescanned
+            scanned[i]->deps.clear();
+            scanned[i]->resolvedDeps = false;
+            scanned[i]->traversed = false;
+            for (auto& [depPath, alias] : directives[i]) {
+                string depName = dependencyName(depPath);
+                fileRecords[i].deps.push_back(depName);
+                // Missing files are reported when resolving dependencies
+                if (discovered.insert(depName).second && std::filesystem::exists(projectRootPath + depName)) next.push_back(depName);
+            }
+            unitDirectives[scanned[i]] = std::move(directives[i]);
+            records[frontier[i]] = std::move(fileRecords[i]);
+        }
+        frontier = std::move(next);
+    }
+    errorHandler::flushErrorBuffers();
 }
 
-CSLModule* Preprocessor::scanFile(string moduleName) {
+CSLModule* Preprocessor::scanFile(string moduleName, Scanner& scanner) {
     string fullPath = projectRootPath + moduleName;
-    vector<Token> tokens = scanner.tokenizeSource(readFile(fullPath), moduleName);
-    CSLModule* unit = new CSLModule(tokens, scanner.getFile());
-    allUnits[moduleName] = unit;
-    curUnit = unit;
+    // Kept modules outlive the build, their files can't be mapped since editors truncate files when saving them
+    auto mapping = std::make_unique<MappedFile>(fullPath, keepUnits);
+    if (!mapping->isValid()) addSystemError("Couldn't read file " + fullPath);
+    File* file = new File(moduleName, std::move(mapping));
+    vector<Token> tokens = scanner.tokenizeSource(file);
+    return new CSLModule(tokens, file);
+}
 
-    // Macros
+// Returns the module scanned by the previous call if it's file wasn't modified since, nullptr otherwise
+CSLModule* Preprocessor::findKeptUnit(const string& moduleName) {
+    auto it = keptUnits.find(moduleName);
+    if (it == keptUnits.end()) return nullptr;
+    std::error_code ec;
+    int64_t mtime = last_write_time(projectRootPath + moduleName, ec).time_since_epoch().count();
+    if (ec || keptRecords.at(moduleName).mtime != mtime) return nullptr;
+    return it->second;
+}
 
+// Content is only hashed if the modification time differs from the one in the last build
+ModuleRecord Preprocessor::recordFile(string moduleName, std::string_view source) {
+    ModuleRecord record;
+    std::error_code ec;
+    record.mtime = last_write_time(projectRootPath + moduleName, ec).time_since_epoch().count();
+    auto it = prevRecords.find(moduleName);
+    if (!ec && it != prevRecords.end() && it->second.mtime == record.mtime) record.hash = it->second.hash;
+    else record.hash = hashSource(source);
+    return record;
+}
 
-    // Dependencies
-    vector<pair<Token, Token>> depsToParse = retrieveDirectives(unit);
+// Links modules to their dependencies in the order they're imported, depth first, which is what detects cyclical imports
+// Uses an explicit stack so long import chains can't overflow the call stack
+void Preprocessor::resolveDependencies(CSLModule* unit) {
+    // Module being resolved and the index of it's next import
+    vector<pair<CSLModule*, uInt>> stack = { { unit, 0 } };
+    visitedUnits.insert(unit);
 
-    processDirectives(unit, depsToParse);
+    while (!stack.empty()) {
+        auto [cur, next] = stack.back();
+        vector<pair<Token, Token>>& directives = unitDirectives[cur];
+        if (next == directives.size()) {
+            cur->resolvedDeps = true;
+            stack.pop_back();
+            continue;
+        }
+        stack.back().second++;
+        auto& [depPath, alias] = directives[next];
+        string depName = dependencyName(depPath);
 
-    return unit;
+        // Every existing file was already scanned by scanProject
+        if (!allUnits.count(depName)) {
+            addCompileError("File " + depName + " doesn't exist.", depPath);
+            continue;
+        }
+        CSLModule* dep = allUnits[depName];
+        // If we have already visited module 'dep' we add it to the deps list of this module to topsort it later
+        if (visitedUnits.count(dep)) {
+            // If we detect a cyclical import we still continue parsing other files to detect as many errors as possible
+            if (!dep->resolvedDeps) {
+                addCompileError("Cyclical importing detected.", depPath);
+                continue;
+            }
+        }
+        else {
+            visitedUnits.insert(dep);
+            stack.emplace_back(dep, 0);
+        }
+        cur->deps.push_back(Dependency(alias, depPath, dep));
+    }
+}
+
+// Post-order DFS with an explicit stack, so that deep import chains can't overflow the call stack
+// Modules are sorted(and their top level code runs) in import order: every import of a module comes before it, and
+// imports appear in the order they were written in, main is always last
+void Preprocessor::toposort(CSLModule* mainUnit) {
+    // Module being sorted and the index of it's next dependency
+    vector<pair<CSLModule*, uInt>> stack = { { mainUnit, 0 } };
+    mainUnit->traversed = true;
+
+    while (!stack.empty()) {
+        auto [cur, next] = stack.back();
+        if (next == cur->deps.size()) {
+            sortedUnits.push_back(cur);
+            stack.pop_back();
+            continue;
+        }
+        stack.back().second++;
+        CSLModule* dep = cur->deps[next].module;
+        if (dep->traversed) continue;
+        dep->traversed = true;
+        stack.emplace_back(dep, 0);
+    }
+}
+
+// A module is dirty if it's new, it's contents or imports changed, or if any of it's dependencies is dirty
+void Preprocessor::markDirtyUnits() {
+    for (CSLModule* unit : sortedUnits) {
+        ModuleRecord& record = records[unit->file->name];
+        auto prev = prevRecords.find(unit->file->name);
+        bool dirty = prev == prevRecords.end() || prev->second.hash != record.hash || prev->second.deps != record.deps;
+        for (Dependency& dep : unit->deps) {
+            if (dirtyUnits.contains(dep.module)) dirty = true;
+        }
+        if (dirty) dirtyUnits.insert(unit);
+    }
 }
 
-void Preprocessor::toposort(CSLModule* unit) {
-    //TODO: we can get a stack overflow if this goes into deep recursion, try making a iterative stack based DFS implementation
-    //TODO: basically implement Kahn's algorithm...
-    unit->traversed = true;
-    for (Dependency& dep : unit->deps) {
-        if (!dep.module->traversed) toposort(dep.module);
+#pragma region Import graph
+// Text file, a header followed by: module name, then mtime, hash and number of imports, then a line per import
+#define IMPORT_GRAPH_HEADER "CSLDEPS 1"
+
+string Preprocessor::graphPath() {
+    return projectRootPath + "main.csldeps";
+}
+
+void Preprocessor::loadImportGraph() {
+    std::ifstream in(graphPath());
+    string line;
+    if (!std::getline(in, line) || line != IMPORT_GRAPH_HEADER) return;
+
+    string name;
+    while (std::getline(in, name)) {
+        ModuleRecord record;
+        uInt depCount;
+        bool complete = false;
+        if (in >> record.mtime >> record.hash >> depCount) {
+            in.ignore(1);
+            for (uInt i = 0; i < depCount && std::getline(in, line); i++) record.deps.push_back(line);
+            complete = record.deps.size() == depCount;
+        }
+        // A truncated graph could mark modules as clean when they aren't, so it's thrown away entirely
+        if (!complete) {
+            prevRecords.clear();
+            return;
+        }
+        prevRecords[name] = std::move(record);
     }
-    sortedUnits.push_back(unit);
 }
 
+void Preprocessor::commitImportGraph() {
+    prevRecords = records;
+    std::ofstream out(graphPath(), std::ios::trunc);
+    if (!out.is_open()) return;
+    out << IMPORT_GRAPH_HEADER << '\n';
+    for (auto& [name, record] : records) {
+        out << name << '\n' << record.mtime << ' ' << record.hash << ' ' << record.deps.size() << '\n';
+        for (string& dep : record.deps) out << dep << '\n';
+    }
+}
+#pragma endregion
+
 // Gets directives to import into the parserCurrent file
 vector<pair<Token, Token>> Preprocessor::retrieveDirectives(CSLModule* unit) {
     vector<Token>& tokens = unit->tokens;
@@ -89,7 +331,7 @@ vector<pair<Token, Token>> Preprocessor::retrieveDirectives(CSLModule* unit) {
         // Add a dependency
         if (token.type == TokenType::IMPORT) {
             // Move to dependency name
-            if (match(TokenType::STRING, tokens, ++i)) {
+            if (!match(TokenType::STRING, tokens, ++i)) {
                 addCompileError("Expected a module name.", getErrorToken(i));
                 continue;
             }
@@ -115,35 +357,3 @@ vector<pair<Token, Token>> Preprocessor::retrieveDirectives(CSLModule* unit) {
 
     return importTokens;
 }
-
-// Processes directives to import into the parserCurrent file
-void Preprocessor::processDirectives(CSLModule* unit, vector<pair<Token, Token>>& depsToParse) {
-    for (auto& [path, alias] : depsToParse) {
-        string depName = path.getLexeme();
-        std::cout << depName << '\n';
-        depName = depName.substr(1, depName.size() - 2); // Extract dependency name from "" (it's a string)
-
-        // If we have already scanned module with name 'dep' we add it to the deps list of this module to topsort it later
-        if (allUnits.count(depName)) {
-            // If we detect a cyclical import we still continue parsing other files to detect as many errors as possible
-            if (!allUnits[depName]->resolvedDeps) {
-                addCompileError("Cyclical importing detected.", path);
-                continue;
-            }
-            unit->deps.push_back(Dependency(alias, path, allUnits[depName]));
-
-            continue;
-        }
-
-        std::filesystem::path p(projectRootPath + depName);
-        if (std::filesystem::exists(p)) {
-            Dependency dep = Dependency(alias, path, scanFile(depName));
-            unit->deps.push_back(dep);
-        }
-        else {
-            addCompileError("File " + depName + " doesn't exist.", path);
-        }
-    }
-
-    unit->resolvedDeps = true;
-}
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <unordered_set>
 #include <memory>
 #include <tuple>
+#include <cstdint>
+
+class PhaseStats;
 
 namespace preprocessing {
     using std::unordered_set;
@@ -12,27 +15,62 @@ namespace preprocessing {
     using std::unique_ptr;
     using std::pair;
 
+    // What is known about a module from the last successful build, persisted in main.csldeps next to main.csl
+    struct ModuleRecord {
+        int64_t mtime = 0;
+        uInt64 hash = 0;
+        vector<string> deps;
+    };
+
     class Preprocessor {
     public:
-        Preprocessor();
+        // If 'keepUnits' is set the preprocessor owns the modules it produces and reuses the ones whose file didn't change
+        // on the next call to preprocessProject, otherwise they are owned(and deleted) by the compiler
+        Preprocessor(bool keepUnits = false);
         ~Preprocessor();
-        void preprocessProject(string mainFilePath);
+        // If 'stats' is given, scanning and the rest of preprocessing are timed as separate phases
+        void preprocessProject(string mainFilePath, PhaseStats* stats = nullptr);
+        // Deletes every kept module, so the next call scans(and the parser parses) everything from scratch
+        void releaseUnits();
 
         vector<CSLModule*> getSortedUnits() { return sortedUnits; }
+        // Modules whose source or imports changed since the last build, along with everything that depends on them,
+        // in the same order as getSortedUnits()
+        vector<CSLModule*> getDirtyUnits();
+        bool isDirty(CSLModule* unit) { return dirtyUnits.contains(unit); }
+        // Saves the import graph of this run, should only be called once the project built successfully
+        // so that modules which failed to compile are still dirty on the next run
+        void commitImportGraph();
     private:
         string projectRootPath;
-        Scanner scanner;
-        CSLModule* curUnit;
+        bool keepUnits;
 
         unordered_map<string, CSLModule*> allUnits;
+        // Modules produced by the previous call, only used if 'keepUnits' is set
+        unordered_map<string, CSLModule*> keptUnits;
+        unordered_map<string, ModuleRecord> keptRecords;
+        unordered_map<CSLModule*, vector<pair<Token, Token>>> keptDirectives;
+        // Graph of the last successful build, and the one being built in this run
+        unordered_map<string, ModuleRecord> prevRecords;
+        unordered_map<string, ModuleRecord> records;
+        unordered_set<CSLModule*> dirtyUnits;
+        // Imports of every scanned module, resolved once the whole project is scanned
+        unordered_map<CSLModule*, vector<pair<Token, Token>>> unitDirectives;
+        unordered_set<CSLModule*> visitedUnits;
         vector<CSLModule*> sortedUnits;
 
         vector<pair<Token, Token>> retrieveDirectives(CSLModule* unit);
 
-        void processDirectives(CSLModule* unit, vector<pair<Token, Token>>& depsToParse);
+        void scanProject(string mainModuleName);
+        CSLModule* scanFile(string unitName, Scanner& scanner);
+        CSLModule* findKeptUnit(const string& moduleName);
+        ModuleRecord recordFile(string moduleName, std::string_view source);
+        void resolveDependencies(CSLModule* unit);
+        void toposort(CSLModule* mainUnit);
+        void markDirtyUnits();
 
-        CSLModule* scanFile(string unitName);
-        void toposort(CSLModule* unit);
+        string graphPath();
+        void loadImportGraph();
     };
 
 }
\ No newline at end of file
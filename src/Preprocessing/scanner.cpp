@@ -1,8 +1,16 @@
 #include "scanner.h"
+#include "simdScan.h"
 #include <iostream>
+#include <array>
 
-// Map to convert keywords in string form to their corresponding TokenType
-std::unordered_map<string, TokenType> keywordToTokenType = {
+namespace {
+    struct Keyword {
+        std::string_view str;
+        TokenType type = TokenType::IDENTIFIER;
+    };
+
+    // Every keyword of the language, the lookup table below is generated from this at compile time
+    constexpr Keyword keywords[] = {
         {"and", TokenType::AND},
         {"break", TokenType::BREAK},
         {"class", TokenType::CLASS},
@@ -33,7 +41,48 @@ std::unordered_map<string, TokenType> keywordToTokenType = {
         {"addMacro", TokenType::ADDMACRO},
         {"expr", TokenType::EXPR},
         {"tt", TokenType::TT}
-};
+    };
+
+    // Large enough that a collision free seed is found after a few tries, hashKeyword returns 7 bits
+    constexpr uInt KEYWORD_TABLE_SIZE = 128;
+
+    constexpr uInt hashKeyword(std::string_view str, uInt seed) {
+        // FNV-1a
+        uInt hash = 2166136261u ^ seed;
+        for (char c : str) {
+            hash ^= static_cast<byte>(c);
+            hash *= 16777619u;
+        }
+        // High bits depend on every character, low bits of a product only depend on the low bits of it's operands
+        return hash >> 25;
+    }
+
+    // Finds the first seed for which no 2 keywords end up in the same slot, making the hash perfect for the keyword set
+    constexpr uInt findKeywordSeed() {
+        for (uInt seed = 0;; seed++) {
+            bool used[KEYWORD_TABLE_SIZE] = {};
+            bool collision = false;
+            for (const Keyword& keyword : keywords) {
+                uInt slot = hashKeyword(keyword.str, seed);
+                if (used[slot]) {
+                    collision = true;
+                    break;
+                }
+                used[slot] = true;
+            }
+            if (!collision) return seed;
+        }
+    }
+    constexpr uInt keywordSeed = findKeywordSeed();
+
+    constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> buildKeywordTable() {
+        std::array<Keyword, KEYWORD_TABLE_SIZE> table{};
+        for (const Keyword& keyword : keywords) table[hashKeyword(keyword.str, keywordSeed)] = keyword;
+        return table;
+    }
+    // Empty slots have an empty string, which never matches an identifier
+    constexpr std::array<Keyword, KEYWORD_TABLE_SIZE> keywordTable = buildKeywordTable();
+}
 
 using namespace preprocessing;
 
@@ -46,9 +95,9 @@ Scanner::Scanner() {
     curFile = nullptr;
 }
 
-vector<Token> Scanner::tokenizeSource(string source, string sourceName) {
+vector<Token> Scanner::tokenizeSource(File* file) {
     // Setup
-    curFile = new File(source, sourceName);
+    curFile = file;
     line = 0;
     start = 0;
     current = start;
@@ -167,19 +216,21 @@ void Scanner::consumeWhitespace() {
         case ' ':
         case '\r':
         case '\t':
-            advance();
+            current = skipWhitespace(curFile->sourceFile, current);
             break;
         case '/':
-            // Standard comment
-            if (peekNext() == '/') while (!isAtEnd() && peek() != '\n') advance();
+            // Standard comment, the '\n' is left for scanToken
+            if (peekNext() == '/') current = findEither(curFile->sourceFile, current, '\n', '\n');
             // Multi-line comment
             else if (peekNext() == '*') {
                 advance();
                 advance();
-                while (!isAtEnd() && !(peek() == '*' && peekNext() == '/')) {
+                while (true) {
+                    current = findEither(curFile->sourceFile, current, '*', '\n');
+                    if (isAtEnd() || (peek() == '*' && peekNext() == '/')) break;
                     if (peek() == '\n') {
                         line++;
-                        curFile->lines.push_back(current);
+                        curFile->lines.push_back(current + 1);
                     }
                     advance();
                 }
@@ -199,12 +250,11 @@ void Scanner::consumeWhitespace() {
 }
 
 Token Scanner::string_() {
-    while (!isAtEnd()) {
-        if (peek() == '"') break;
-        if (peek() == '\n') {
-            line++;
-            curFile->lines.push_back(current);
-        }
+    while (true) {
+        current = findEither(curFile->sourceFile, current, '"', '\n');
+        if (isAtEnd() || peek() == '"') break;
+        line++;
+        curFile->lines.push_back(current + 1);
         advance();
     }
 
@@ -231,21 +281,22 @@ Token Scanner::number() {
 
 Token Scanner::identifier() {
     //first character of the identifier has to be alphabetical, rest can be alphanumerical and '_'
-    while (isalnum(peek()) || peek() == '_') advance();
+    current = skipIdentifier(curFile->sourceFile, current);
     return makeToken(identifierType());
 }
 
 TokenType Scanner::identifierType() {
-    string tokenString = curFile->sourceFile.substr(start, current - start);
+    std::string_view tokenString = curFile->sourceFile.substr(start, current - start);
 
-    // language keyword
-    if (keywordToTokenType.contains(tokenString)) return keywordToTokenType[tokenString];
+    // language keyword, every keyword has it's own slot so a single comparison is enough
+    const Keyword& keyword = keywordTable[hashKeyword(tokenString, keywordSeed)];
+    if (keyword.str == tokenString) return keyword.type;
 
     // variable name
     return TokenType::IDENTIFIER;
 }
 
-bool Scanner::checkKeyword(int keywordOffset, string keyword) {
+bool Scanner::checkKeyword(int keywordOffset, std::string_view keyword) {
     if (!isIndexInFile(start + keywordOffset + keyword.length())) return false;
     if (curFile->sourceFile.substr(start + keywordOffset, keyword.length()) == keyword) {
         return true;
@@ -1,11 +1,12 @@
 #pragma once
-#include "../moduleDefs.h"
+#include "../modulesDefs.h"
 
 namespace preprocessing {
 
 	class Scanner {
 	public:
-		vector<Token> tokenizeSource(string source, string sourcename);
+		// Tokens reference the contents of 'file' directly, so it has to outlive them
+		vector<Token> tokenizeSource(File* file);
 		File* getFile() { return curFile; }
 		Scanner();
 	private:
@@ -22,7 +23,7 @@ namespace preprocessing {
 		bool isAtEnd();
 		bool isIndexInFile(int index);
 		bool match(char expected);
-		bool checkKeyword(int keywordOffset, string keyword);
+		bool checkKeyword(int keywordOffset, std::string_view keyword);
 		char advance();
 		char peek();
 		char peekNext();
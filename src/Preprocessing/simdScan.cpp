@@ -0,0 +1,152 @@
+#include "simdScan.h"
+#include "../cpuFeatures.h"
+#include <bit>
+
+using namespace preprocessing;
+
+#pragma region Scalar
+static bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static uInt64 skipWhitespaceScalar(std::string_view src, uInt64 pos) {
+    while (pos < src.size() && (src[pos] == ' ' || src[pos] == '\t' || src[pos] == '\r')) pos++;
+    return pos;
+}
+
+static uInt64 skipIdentifierScalar(std::string_view src, uInt64 pos) {
+    while (pos < src.size() && isIdentifierChar(src[pos])) pos++;
+    return pos;
+}
+
+static uInt64 findEitherScalar(std::string_view src, uInt64 pos, char a, char b) {
+    while (pos < src.size() && src[pos] != a && src[pos] != b) pos++;
+    return pos;
+}
+#pragma endregion
+
+#ifdef CPU_X64
+// Every vector loop handles whole blocks and leaves the remaining tail(less than a block) to the scalar version
+#pragma region SSE2
+static uInt whitespaceMaskSSE2(__m128i v) {
+    __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+    return _mm_movemask_epi8(ws);
+}
+
+// Signed comparisons are fine here, bytes >= 0x80 are negative and fail every range check
+static __m128i inRangeSSE2(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+static uInt identifierMaskSSE2(__m128i v) {
+    // Setting bit 5 maps 'A'-'Z' to 'a'-'z'
+    __m128i letter = inRangeSSE2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i digit = inRangeSSE2(v, '0', '9');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore));
+}
+
+static uInt64 skipWhitespaceSSE2(std::string_view src, uInt64 pos) {
+    for (; pos + 16 <= src.size(); pos += 16) {
+        uInt mask = whitespaceMaskSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + pos)));
+        if (mask != 0xFFFF) return pos + std::countr_zero(~mask);
+    }
+    return skipWhitespaceScalar(src, pos);
+}
+
+static uInt64 skipIdentifierSSE2(std::string_view src, uInt64 pos) {
+    for (; pos + 16 <= src.size(); pos += 16) {
+        uInt mask = identifierMaskSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + pos)));
+        if (mask != 0xFFFF) return pos + std::countr_zero(~mask);
+    }
+    return skipIdentifierScalar(src, pos);
+}
+
+static uInt64 findEitherSSE2(std::string_view src, uInt64 pos, char a, char b) {
+    __m128i va = _mm_set1_epi8(a);
+    __m128i vb = _mm_set1_epi8(b);
+    for (; pos + 16 <= src.size(); pos += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + pos));
+        uInt mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if (mask != 0) return pos + std::countr_zero(mask);
+    }
+    return findEitherScalar(src, pos, a, b);
+}
+#pragma endregion
+
+#pragma region AVX2
+TARGET_AVX2 static __m256i inRangeAVX2(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+TARGET_AVX2 static uInt64 skipWhitespaceAVX2(std::string_view src, uInt64 pos) {
+    for (; pos + 32 <= src.size(); pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src.data() + pos));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+        ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+        uInt mask = _mm256_movemask_epi8(ws);
+        if (mask != 0xFFFFFFFF) return pos + std::countr_zero(~mask);
+    }
+    return skipWhitespaceSSE2(src, pos);
+}
+
+TARGET_AVX2 static uInt64 skipIdentifierAVX2(std::string_view src, uInt64 pos) {
+    for (; pos + 32 <= src.size(); pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src.data() + pos));
+        __m256i letter = inRangeAVX2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i digit = inRangeAVX2(v, '0', '9');
+        __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+        uInt mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), underscore));
+        if (mask != 0xFFFFFFFF) return pos + std::countr_zero(~mask);
+    }
+    return skipIdentifierSSE2(src, pos);
+}
+
+TARGET_AVX2 static uInt64 findEitherAVX2(std::string_view src, uInt64 pos, char a, char b) {
+    __m256i va = _mm256_set1_epi8(a);
+    __m256i vb = _mm256_set1_epi8(b);
+    for (; pos + 32 <= src.size(); pos += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src.data() + pos));
+        uInt mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)));
+        if (mask != 0) return pos + std::countr_zero(mask);
+    }
+    return findEitherSSE2(src, pos, a, b);
+}
+#pragma endregion
+#endif
+
+namespace {
+    struct ScanFunctions {
+        uInt64 (*skipWhitespace)(std::string_view, uInt64);
+        uInt64 (*skipIdentifier)(std::string_view, uInt64);
+        uInt64 (*findEither)(std::string_view, uInt64, char, char);
+    };
+
+    const ScanFunctions& getScanFunctions() {
+        // Initialized once, thread safe
+        static const ScanFunctions functions = []() -> ScanFunctions {
+#ifdef CPU_X64
+            switch (selectSimdLevel()) {
+            case SimdLevel::AVX2: return { skipWhitespaceAVX2, skipIdentifierAVX2, findEitherAVX2 };
+            case SimdLevel::SSE2: return { skipWhitespaceSSE2, skipIdentifierSSE2, findEitherSSE2 };
+            case SimdLevel::SCALAR: break;
+            }
+#endif
+            return { skipWhitespaceScalar, skipIdentifierScalar, findEitherScalar };
+        }();
+        return functions;
+    }
+}
+
+uInt64 preprocessing::skipWhitespace(std::string_view src, uInt64 pos) {
+    return getScanFunctions().skipWhitespace(src, pos);
+}
+
+uInt64 preprocessing::skipIdentifier(std::string_view src, uInt64 pos) {
+    return getScanFunctions().skipIdentifier(src, pos);
+}
+
+uInt64 preprocessing::findEither(std::string_view src, uInt64 pos, char a, char b) {
+    return getScanFunctions().findEither(src, pos, a, b);
+}
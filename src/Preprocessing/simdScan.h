@@ -0,0 +1,16 @@
+#pragma once
+#include "../common.h"
+#include <string_view>
+
+// Scanning primitives used by the scanner, they classify 16(SSE2) or 32(AVX2) bytes at a time
+// The widest instruction set supported by the CPU is picked the first time any of them is called, on anything other
+// than x64 they fall back to plain loops, debugFlags::maxSimdLevel can restrict the choice
+// All of them return an index in [pos, src.size()], src.size() meaning nothing was found
+namespace preprocessing {
+    // Index of the first character at or after 'pos' that isn't ' ', '\t' or '\r'
+    uInt64 skipWhitespace(std::string_view src, uInt64 pos);
+    // Index of the first character at or after 'pos' that isn't alphanumeric or '_'
+    uInt64 skipIdentifier(std::string_view src, uInt64 pos);
+    // Index of the first occurrence of either 'a' or 'b' at or after 'pos'
+    uInt64 findEither(std::string_view src, uInt64 pos, char a, char b);
+}
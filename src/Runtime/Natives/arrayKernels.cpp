@@ -0,0 +1,345 @@
+#include "arrayKernels.h"
+#include "../../cpuFeatures.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+using namespace runtime;
+
+#pragma region Scalar
+// Every scalar kernel takes the index to start from, vector kernels use them for the remaining tail
+static double sumScalar(const double* src, uInt64 n, uInt64 i = 0) {
+	double total = 0;
+	for (; i < n; i++) total += src[i];
+	return total;
+}
+
+static double dotScalar(const double* a, const double* b, uInt64 n, uInt64 i = 0) {
+	double total = 0;
+	for (; i < n; i++) total += a[i] * b[i];
+	return total;
+}
+
+// std::min/max and the min/max instructions each drop NaNs depending on which operand they're in, so every kernel
+// tracks NaNs on the side and returns NaN if there was one
+static double minScalar(const double* src, uInt64 n, uInt64 i = 0) {
+	double res = src[i];
+	bool hasNaN = false;
+	for (; i < n; i++) {
+		res = std::min(res, src[i]);
+		hasNaN |= std::isnan(src[i]);
+	}
+	return hasNaN ? std::numeric_limits<double>::quiet_NaN() : res;
+}
+
+static double maxScalar(const double* src, uInt64 n, uInt64 i = 0) {
+	double res = src[i];
+	bool hasNaN = false;
+	for (; i < n; i++) {
+		res = std::max(res, src[i]);
+		hasNaN |= std::isnan(src[i]);
+	}
+	return hasNaN ? std::numeric_limits<double>::quiet_NaN() : res;
+}
+
+static void addScalarLoop(double* dst, const double* a, const double* b, uInt64 n, uInt64 i = 0) {
+	for (; i < n; i++) dst[i] = a[i] + b[i];
+}
+
+static void addValScalar(double* dst, const double* src, double val, uInt64 n, uInt64 i = 0) {
+	for (; i < n; i++) dst[i] = src[i] + val;
+}
+
+static void mulValScalar(double* dst, const double* src, double val, uInt64 n, uInt64 i = 0) {
+	for (; i < n; i++) dst[i] = src[i] * val;
+}
+
+static void fillScalar(double* dst, double val, uInt64 n, uInt64 i = 0) {
+	for (; i < n; i++) dst[i] = val;
+}
+
+static int64_t indexOfScalar(const double* src, double val, uInt64 n, uInt64 i = 0) {
+	for (; i < n; i++) {
+		if (FLOAT_EQ(src[i], val)) return i;
+	}
+	return -1;
+}
+#pragma endregion
+
+#ifdef CPU_X64
+#pragma region SSE2
+static double sumSSE2(const double* src, uInt64 n) {
+	// 2 accumulators hide the latency of the adds
+	__m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+	uInt64 i = 0;
+	for (; i + 4 <= n; i += 4) {
+		acc0 = _mm_add_pd(acc0, _mm_loadu_pd(src + i));
+		acc1 = _mm_add_pd(acc1, _mm_loadu_pd(src + i + 2));
+	}
+	__m128d acc = _mm_add_pd(acc0, acc1);
+	return _mm_cvtsd_f64(acc) + _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)) + sumScalar(src, n, i);
+}
+
+static double dotSSE2(const double* a, const double* b, uInt64 n) {
+	__m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+	uInt64 i = 0;
+	for (; i + 4 <= n; i += 4) {
+		acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+		acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+	}
+	__m128d acc = _mm_add_pd(acc0, acc1);
+	return _mm_cvtsd_f64(acc) + _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)) + dotScalar(a, b, n, i);
+}
+
+static double minSSE2(const double* src, uInt64 n) {
+	if (n < 2) return minScalar(src, n);
+	__m128d acc = _mm_loadu_pd(src);
+	__m128d nans = _mm_cmpunord_pd(acc, acc);
+	uInt64 i = 2;
+	for (; i + 2 <= n; i += 2) {
+		__m128d v = _mm_loadu_pd(src + i);
+		acc = _mm_min_pd(acc, v);
+		nans = _mm_or_pd(nans, _mm_cmpunord_pd(v, v));
+	}
+	if (_mm_movemask_pd(nans) != 0) return std::numeric_limits<double>::quiet_NaN();
+	double res = std::min(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+	//the tail goes first, std::min keeps it if it's NaN
+	return i < n ? std::min(minScalar(src, n, i), res) : res;
+}
+
+static double maxSSE2(const double* src, uInt64 n) {
+	if (n < 2) return maxScalar(src, n);
+	__m128d acc = _mm_loadu_pd(src);
+	__m128d nans = _mm_cmpunord_pd(acc, acc);
+	uInt64 i = 2;
+	for (; i + 2 <= n; i += 2) {
+		__m128d v = _mm_loadu_pd(src + i);
+		acc = _mm_max_pd(acc, v);
+		nans = _mm_or_pd(nans, _mm_cmpunord_pd(v, v));
+	}
+	if (_mm_movemask_pd(nans) != 0) return std::numeric_limits<double>::quiet_NaN();
+	double res = std::max(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+	//the tail goes first, std::max keeps it if it's NaN
+	return i < n ? std::max(maxScalar(src, n, i), res) : res;
+}
+
+static void addSSE2(double* dst, const double* a, const double* b, uInt64 n) {
+	uInt64 i = 0;
+	for (; i + 2 <= n; i += 2) _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	addScalarLoop(dst, a, b, n, i);
+}
+
+static void addValSSE2(double* dst, const double* src, double val, uInt64 n) {
+	__m128d v = _mm_set1_pd(val);
+	uInt64 i = 0;
+	for (; i + 2 <= n; i += 2) _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(src + i), v));
+	addValScalar(dst, src, val, n, i);
+}
+
+static void mulValSSE2(double* dst, const double* src, double val, uInt64 n) {
+	__m128d v = _mm_set1_pd(val);
+	uInt64 i = 0;
+	for (; i + 2 <= n; i += 2) _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_loadu_pd(src + i), v));
+	mulValScalar(dst, src, val, n, i);
+}
+
+static void fillSSE2(double* dst, double val, uInt64 n) {
+	__m128d v = _mm_set1_pd(val);
+	uInt64 i = 0;
+	for (; i + 2 <= n; i += 2) _mm_storeu_pd(dst + i, v);
+	fillScalar(dst, val, n, i);
+}
+
+static int64_t indexOfSSE2(const double* src, double val, uInt64 n) {
+	__m128d v = _mm_set1_pd(val);
+	__m128d eps = _mm_set1_pd(DBL_EPSILON);
+	// Clearing the sign bit gives the absolute value
+	__m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFF));
+	uInt64 i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m128d diff = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(src + i), v), absMask);
+		int mask = _mm_movemask_pd(_mm_cmple_pd(diff, eps));
+		if (mask != 0) return i + std::countr_zero(static_cast<uInt>(mask));
+	}
+	return indexOfScalar(src, val, n, i);
+}
+#pragma endregion
+
+#pragma region AVX2
+TARGET_AVX2 static double horizontalSumAVX2(__m256d v) {
+	__m128d half = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(half) + _mm_cvtsd_f64(_mm_unpackhi_pd(half, half));
+}
+
+TARGET_AVX2 static double sumAVX2(const double* src, uInt64 n) {
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	uInt64 i = 0;
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(src + i));
+		acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(src + i + 4));
+	}
+	return horizontalSumAVX2(_mm256_add_pd(acc0, acc1)) + sumScalar(src, n, i);
+}
+
+TARGET_AVX2 static double dotAVX2(const double* a, const double* b, uInt64 n) {
+	// FMA isn't implied by AVX2, so the multiply and add are kept separate
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	uInt64 i = 0;
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+	}
+	return horizontalSumAVX2(_mm256_add_pd(acc0, acc1)) + dotScalar(a, b, n, i);
+}
+
+TARGET_AVX2 static double minAVX2(const double* src, uInt64 n) {
+	if (n < 4) return minScalar(src, n);
+	__m256d acc = _mm256_loadu_pd(src);
+	__m256d nans = _mm256_cmp_pd(acc, acc, _CMP_UNORD_Q);
+	uInt64 i = 4;
+	for (; i + 4 <= n; i += 4) {
+		__m256d v = _mm256_loadu_pd(src + i);
+		acc = _mm256_min_pd(acc, v);
+		nans = _mm256_or_pd(nans, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+	}
+	if (_mm256_movemask_pd(nans) != 0) return std::numeric_limits<double>::quiet_NaN();
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+	double res = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+	return i < n ? std::min(minScalar(src, n, i), res) : res;
+}
+
+TARGET_AVX2 static double maxAVX2(const double* src, uInt64 n) {
+	if (n < 4) return maxScalar(src, n);
+	__m256d acc = _mm256_loadu_pd(src);
+	__m256d nans = _mm256_cmp_pd(acc, acc, _CMP_UNORD_Q);
+	uInt64 i = 4;
+	for (; i + 4 <= n; i += 4) {
+		__m256d v = _mm256_loadu_pd(src + i);
+		acc = _mm256_max_pd(acc, v);
+		nans = _mm256_or_pd(nans, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+	}
+	if (_mm256_movemask_pd(nans) != 0) return std::numeric_limits<double>::quiet_NaN();
+	double lanes[4];
+	_mm256_storeu_pd(lanes, acc);
+	double res = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	return i < n ? std::max(maxScalar(src, n, i), res) : res;
+}
+
+TARGET_AVX2 static void addAVX2(double* dst, const double* a, const double* b, uInt64 n) {
+	uInt64 i = 0;
+	for (; i + 4 <= n; i += 4) _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	addScalarLoop(dst, a, b, n, i);
+}
+
+TARGET_AVX2 static void addValAVX2(double* dst, const double* src, double val, uInt64 n) {
+	__m256d v = _mm256_set1_pd(val);
+	uInt64 i = 0;
+	for (; i + 4 <= n; i += 4) _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(src + i), v));
+	addValScalar(dst, src, val, n, i);
+}
+
+TARGET_AVX2 static void mulValAVX2(double* dst, const double* src, double val, uInt64 n) {
+	__m256d v = _mm256_set1_pd(val);
+	uInt64 i = 0;
+	for (; i + 4 <= n; i += 4) _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_loadu_pd(src + i), v));
+	mulValScalar(dst, src, val, n, i);
+}
+
+TARGET_AVX2 static void fillAVX2(double* dst, double val, uInt64 n) {
+	__m256d v = _mm256_set1_pd(val);
+	uInt64 i = 0;
+	for (; i + 4 <= n; i += 4) _mm256_storeu_pd(dst + i, v);
+	fillScalar(dst, val, n, i);
+}
+
+TARGET_AVX2 static int64_t indexOfAVX2(const double* src, double val, uInt64 n) {
+	__m256d v = _mm256_set1_pd(val);
+	__m256d eps = _mm256_set1_pd(DBL_EPSILON);
+	__m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFF));
+	uInt64 i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256d diff = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(src + i), v), absMask);
+		int mask = _mm256_movemask_pd(_mm256_cmp_pd(diff, eps, _CMP_LE_OQ));
+		if (mask != 0) return i + std::countr_zero(static_cast<uInt>(mask));
+	}
+	return indexOfScalar(src, val, n, i);
+}
+#pragma endregion
+#endif
+
+namespace {
+	// Scalar kernels take a start index, these wrappers give them the same signature as the vector ones
+	double sumBase(const double* src, uInt64 n) { return sumScalar(src, n); }
+	double dotBase(const double* a, const double* b, uInt64 n) { return dotScalar(a, b, n); }
+	double minBase(const double* src, uInt64 n) { return minScalar(src, n); }
+	double maxBase(const double* src, uInt64 n) { return maxScalar(src, n); }
+	void addBase(double* dst, const double* a, const double* b, uInt64 n) { addScalarLoop(dst, a, b, n); }
+	void addValBase(double* dst, const double* src, double val, uInt64 n) { addValScalar(dst, src, val, n); }
+	void mulValBase(double* dst, const double* src, double val, uInt64 n) { mulValScalar(dst, src, val, n); }
+	void fillBase(double* dst, double val, uInt64 n) { fillScalar(dst, val, n); }
+	int64_t indexOfBase(const double* src, double val, uInt64 n) { return indexOfScalar(src, val, n); }
+
+	struct KernelFunctions {
+		double (*sum)(const double*, uInt64);
+		double (*dot)(const double*, const double*, uInt64);
+		double (*min)(const double*, uInt64);
+		double (*max)(const double*, uInt64);
+		void (*add)(double*, const double*, const double*, uInt64);
+		void (*addScalar)(double*, const double*, double, uInt64);
+		void (*mulScalar)(double*, const double*, double, uInt64);
+		void (*fill)(double*, double, uInt64);
+		int64_t (*indexOf)(const double*, double, uInt64);
+	};
+
+	const KernelFunctions& getKernels() {
+		// Initialized once, thread safe
+		static const KernelFunctions functions = []() -> KernelFunctions {
+#ifdef CPU_X64
+			switch (selectSimdLevel()) {
+			case SimdLevel::AVX2: return { sumAVX2, dotAVX2, minAVX2, maxAVX2, addAVX2, addValAVX2, mulValAVX2, fillAVX2, indexOfAVX2 };
+			case SimdLevel::SSE2: return { sumSSE2, dotSSE2, minSSE2, maxSSE2, addSSE2, addValSSE2, mulValSSE2, fillSSE2, indexOfSSE2 };
+			case SimdLevel::SCALAR: break;
+			}
+#endif
+			return { sumBase, dotBase, minBase, maxBase, addBase, addValBase, mulValBase, fillBase, indexOfBase };
+		}();
+		return functions;
+	}
+}
+
+double kernels::sum(const double* src, uInt64 n) {
+	return getKernels().sum(src, n);
+}
+
+double kernels::dot(const double* a, const double* b, uInt64 n) {
+	return getKernels().dot(a, b, n);
+}
+
+double kernels::min(const double* src, uInt64 n) {
+	return getKernels().min(src, n);
+}
+
+double kernels::max(const double* src, uInt64 n) {
+	return getKernels().max(src, n);
+}
+
+void kernels::add(double* dst, const double* a, const double* b, uInt64 n) {
+	getKernels().add(dst, a, b, n);
+}
+
+void kernels::addScalar(double* dst, const double* src, double val, uInt64 n) {
+	getKernels().addScalar(dst, src, val, n);
+}
+
+void kernels::mulScalar(double* dst, const double* src, double val, uInt64 n) {
+	getKernels().mulScalar(dst, src, val, n);
+}
+
+void kernels::fill(double* dst, double val, uInt64 n) {
+	getKernels().fill(dst, val, n);
+}
+
+int64_t kernels::indexOf(const double* src, double val, uInt64 n) {
+	return getKernels().indexOf(src, val, n);
+}
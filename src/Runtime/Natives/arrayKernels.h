@@ -0,0 +1,23 @@
+#pragma once
+#include "../../common.h"
+
+// Bulk operations over contiguous doubles used by the array natives, they process 2(SSE2) or 4(AVX2) elements at a time
+// The widest instruction set supported by the CPU is picked the first time any of them is called, on anything other
+// than x64 they fall back to plain loops, debugFlags::maxSimdLevel can restrict the choice
+// Reductions use several accumulators, so results can differ from a sequential loop in the last few bits
+namespace runtime::kernels {
+	double sum(const double* src, uInt64 n);
+	double dot(const double* a, const double* b, uInt64 n);
+	// 'n' must be at least 1, the result is NaN if any element is NaN
+	double min(const double* src, uInt64 n);
+	double max(const double* src, uInt64 n);
+	// dst[i] = a[i] + b[i], 'dst' may alias either operand
+	void add(double* dst, const double* a, const double* b, uInt64 n);
+	// dst[i] = src[i] + val, 'dst' may alias 'src'
+	void addScalar(double* dst, const double* src, double val, uInt64 n);
+	// dst[i] = src[i] * val, 'dst' may alias 'src'
+	void mulScalar(double* dst, const double* src, double val, uInt64 n);
+	void fill(double* dst, double val, uInt64 n);
+	// Index of the first element equal to 'val'(using the same epsilon as CSL's ==), -1 if there is none
+	int64_t indexOf(const double* src, double val, uInt64 n);
+}
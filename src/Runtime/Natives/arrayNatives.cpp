@@ -0,0 +1,212 @@
+#include "../nativeRegistry.h"
+#include "arrayKernels.h"
+#include "../../Includes/fmt/format.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace runtime;
+using namespace object;
+
+// Typed arrays are created either with a length(all elements are 0) or from an array of numbers
+template<TypedArrayKind kind>
+static ObjTypedArray* makeTypedArray(Thread* thread, Value init) {
+	if (init.isNumber()) {
+		double length = init.asNumber();
+		if (length < 0 || !IS_INT(length)) thread->nativeError("Length of a typed array must be a positive integer.");
+		return new ObjTypedArray(kind, static_cast<uInt64>(length));
+	}
+	if (!init.isArray()) thread->nativeError("Argument 1 must be a number or an array, got " + init.typeToStr() + ".");
+	ObjArray* arr = init.asArray();
+	// Checked before allocating so that a failed conversion doesn't leave garbage behind
+	for (Value& val : arr->values) {
+		if (!val.isNumber()) thread->nativeError("Typed arrays can only hold numbers, got " + val.typeToStr() + ".");
+	}
+	ObjTypedArray* typedArr = new ObjTypedArray(kind, arr->values.size());
+	for (uInt64 i = 0; i < arr->values.size(); i++) typedArr->set(i, arr->values[i].asNumber());
+	return typedArr;
+}
+
+#pragma region Bulk operations
+// Bulk operations accept both kinds of arrays, Float64Arrays go through the vectorized kernels while everything
+// else is handled one element at a time
+static ObjTypedArray* asFloat64(Value& val) {
+	if (!val.isTypedArray()) return nullptr;
+	ObjTypedArray* arr = val.asTypedArray();
+	return arr->kind == TypedArrayKind::FLOAT64 ? arr : nullptr;
+}
+
+static uInt64 arrayLength(Thread* thread, Value& val, int argIndex) {
+	if (val.isTypedArray()) return val.asTypedArray()->length;
+	if (val.isArray()) return val.asArray()->values.size();
+	thread->nativeError(fmt::format("Argument {} must be an array, got {}.", argIndex + 1, val.typeToStr()));
+}
+
+// Only called after arrayLength succeeded on 'arr'
+static double numberAt(Thread* thread, Value& arr, uInt64 i) {
+	if (arr.isTypedArray()) return arr.asTypedArray()->get(i);
+	Value& val = arr.asArray()->values[i];
+	if (!val.isNumber()) thread->nativeError(fmt::format("Expected an array of numbers, got {} at index {}.", val.typeToStr(), i));
+	return val.asNumber();
+}
+
+static void setNumberAt(Value& arr, uInt64 i, double num) {
+	if (arr.isTypedArray()) return arr.asTypedArray()->set(i, num);
+	ObjArray* objArr = arr.asArray();
+	if (objArr->values[i].isObj()) objArr->numOfHeapPtr--;
+	objArr->values[i] = Value(num);
+}
+
+// New array of the same kind as 'arr'
+static Value makeLike(Value& arr, uInt64 length) {
+	if (arr.isTypedArray()) return Value(new ObjTypedArray(arr.asTypedArray()->kind, length));
+	return Value(new ObjArray(length));
+}
+
+static void checkSameLength(Thread* thread, uInt64 a, uInt64 b) {
+	if (a != b) thread->nativeError(fmt::format("Arrays must have the same length, got {} and {}.", a, b));
+}
+
+static double sumNative(Thread* thread, Value arr) {
+	uInt64 length = arrayLength(thread, arr, 0);
+	if (ObjTypedArray* f64 = asFloat64(arr)) return kernels::sum(f64->as<double>(), length);
+	double total = 0;
+	for (uInt64 i = 0; i < length; i++) total += numberAt(thread, arr, i);
+	return total;
+}
+
+static double dotNative(Thread* thread, Value a, Value b) {
+	uInt64 length = arrayLength(thread, a, 0);
+	checkSameLength(thread, length, arrayLength(thread, b, 1));
+	ObjTypedArray* fa = asFloat64(a);
+	ObjTypedArray* fb = asFloat64(b);
+	if (fa && fb) return kernels::dot(fa->as<double>(), fb->as<double>(), length);
+	double total = 0;
+	for (uInt64 i = 0; i < length; i++) total += numberAt(thread, a, i) * numberAt(thread, b, i);
+	return total;
+}
+
+template<bool isMin>
+static double extremeNative(Thread* thread, Value arr) {
+	uInt64 length = arrayLength(thread, arr, 0);
+	if (length == 0) thread->nativeError("Array is empty.");
+	if (ObjTypedArray* f64 = asFloat64(arr)) {
+		return isMin ? kernels::min(f64->as<double>(), length) : kernels::max(f64->as<double>(), length);
+	}
+	double res = numberAt(thread, arr, 0);
+	for (uInt64 i = 1; i < length; i++) {
+		double num = numberAt(thread, arr, i);
+		res = isMin ? std::min(res, num) : std::max(res, num);
+	}
+	return res;
+}
+
+// Element wise sum of 2 arrays, or of an array and a number, the result is a new array of the same kind as 'a'
+static Value mapAddNative(Thread* thread, Value a, Value b) {
+	uInt64 length = arrayLength(thread, a, 0);
+	if (b.isNumber()) {
+		double num = b.asNumber();
+		// Checking every element before allocating means a failure never leaves a half filled array behind
+		if (a.isArray()) for (uInt64 i = 0; i < length; i++) numberAt(thread, a, i);
+		Value res = makeLike(a, length);
+		if (ObjTypedArray* fa = asFloat64(a)) {
+			kernels::addScalar(asFloat64(res)->as<double>(), fa->as<double>(), num, length);
+		}
+		else for (uInt64 i = 0; i < length; i++) setNumberAt(res, i, numberAt(thread, a, i) + num);
+		return res;
+	}
+	checkSameLength(thread, length, arrayLength(thread, b, 1));
+	if (a.isArray()) for (uInt64 i = 0; i < length; i++) numberAt(thread, a, i);
+	if (b.isArray()) for (uInt64 i = 0; i < length; i++) numberAt(thread, b, i);
+	Value res = makeLike(a, length);
+	ObjTypedArray* fa = asFloat64(a);
+	ObjTypedArray* fb = asFloat64(b);
+	if (fa && fb) kernels::add(asFloat64(res)->as<double>(), fa->as<double>(), fb->as<double>(), length);
+	else for (uInt64 i = 0; i < length; i++) setNumberAt(res, i, numberAt(thread, a, i) + numberAt(thread, b, i));
+	return res;
+}
+
+// Multiplies every element of 'arr' by 'factor' in place
+static Value scaleNative(Thread* thread, Value arr, double factor) {
+	uInt64 length = arrayLength(thread, arr, 0);
+	if (ObjTypedArray* f64 = asFloat64(arr)) kernels::mulScalar(f64->as<double>(), f64->as<double>(), factor, length);
+	else {
+		if (arr.isArray()) for (uInt64 i = 0; i < length; i++) numberAt(thread, arr, i);
+		for (uInt64 i = 0; i < length; i++) setNumberAt(arr, i, numberAt(thread, arr, i) * factor);
+	}
+	return arr;
+}
+
+// Sets every element of 'arr' to 'val', regular arrays accept any value
+static Value fillNative(Thread* thread, Value arr, Value val) {
+	uInt64 length = arrayLength(thread, arr, 0);
+	if (arr.isArray()) {
+		ObjArray* objArr = arr.asArray();
+		std::fill(objArr->values.begin(), objArr->values.end(), val);
+		objArr->numOfHeapPtr = val.isObj() ? length : 0;
+		return arr;
+	}
+	if (!val.isNumber()) thread->nativeError(fmt::format("Typed arrays can only hold numbers, got {}.", val.typeToStr()));
+	if (ObjTypedArray* f64 = asFloat64(arr)) kernels::fill(f64->as<double>(), val.asNumber(), length);
+	else for (uInt64 i = 0; i < length; i++) setNumberAt(arr, i, val.asNumber());
+	return arr;
+}
+
+// Copies all of 'src' to the start of 'dst', 'dst' must be at least as long as 'src'
+static Value copyNative(Thread* thread, Value dst, Value src) {
+	uInt64 dstLength = arrayLength(thread, dst, 0);
+	uInt64 srcLength = arrayLength(thread, src, 1);
+	if (dstLength < srcLength) {
+		thread->nativeError(fmt::format("Destination array is too short, length {} but {} elements are copied.", dstLength, srcLength));
+	}
+	if (dst.isArray() && src.isArray()) {
+		ObjArray* dstArr = dst.asArray();
+		ObjArray* srcArr = src.asArray();
+		std::copy(srcArr->values.begin(), srcArr->values.end(), dstArr->values.begin());
+		dstArr->numOfHeapPtr = 0;
+		for (Value& val : dstArr->values) if (val.isObj()) dstArr->numOfHeapPtr++;
+		return dst;
+	}
+	if (dst.isTypedArray() && src.isTypedArray() && dst.asTypedArray()->kind == src.asTypedArray()->kind) {
+		ObjTypedArray* dstArr = dst.asTypedArray();
+		memmove(dstArr->data, src.asTypedArray()->data, srcLength * dstArr->elementSize());
+		return dst;
+	}
+	if (src.isArray()) for (uInt64 i = 0; i < srcLength; i++) numberAt(thread, src, i);
+	for (uInt64 i = 0; i < srcLength; i++) setNumberAt(dst, i, numberAt(thread, src, i));
+	return dst;
+}
+
+// Index of the first element equal to 'val', -1 if there is none
+static double indexOfNative(Thread* thread, Value arr, Value val) {
+	uInt64 length = arrayLength(thread, arr, 0);
+	if (arr.isArray()) {
+		vector<Value>& values = arr.asArray()->values;
+		for (uInt64 i = 0; i < length; i++) {
+			if (values[i] == val) return i;
+		}
+		return -1;
+	}
+	if (!val.isNumber()) return -1;
+	if (ObjTypedArray* f64 = asFloat64(arr)) return kernels::indexOf(f64->as<double>(), val.asNumber(), length);
+	ObjTypedArray* typedArr = arr.asTypedArray();
+	for (uInt64 i = 0; i < length; i++) {
+		if (FLOAT_EQ(typedArr->get(i), val.asNumber())) return i;
+	}
+	return -1;
+}
+#pragma endregion
+
+void runtime::registerArrayNatives(NativeRegistry& registry) {
+	registry.add<makeTypedArray<TypedArrayKind::FLOAT64>>("Float64Array");
+	registry.add<makeTypedArray<TypedArrayKind::INT32>>("Int32Array");
+	registry.add<makeTypedArray<TypedArrayKind::UINT8>>("Uint8Array");
+	registry.add<sumNative>("arraySum");
+	registry.add<dotNative>("arrayDot");
+	registry.add<extremeNative<true>>("arrayMin");
+	registry.add<extremeNative<false>>("arrayMax");
+	registry.add<mapAddNative>("arrayAdd");
+	registry.add<scaleNative>("arrayScale");
+	registry.add<fillNative>("arrayFill");
+	registry.add<copyNative>("arrayCopy");
+	registry.add<indexOfNative>("arrayIndexOf");
+}
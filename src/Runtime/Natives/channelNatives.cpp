@@ -0,0 +1,127 @@
+#include "../nativeRegistry.h"
+#include "../../Includes/fmt/format.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace runtime;
+using namespace object;
+
+// Channels pass values between threads started with async, nil is what a closed channel returns so it can't be sent
+// var ch = Channel(16);
+// async producer(ch);
+// var val;
+// while ((val = channelRecv(ch)) != nil) { ... }
+
+// Channel() is unbounded, Channel(n) holds at most n values and makes senders wait once it's full
+static bool channelNative(Thread* thread, int argCount, Value* args) {
+	if (argCount > 1) thread->nativeError(fmt::format("Expected 0 or 1 arguments but got {}.", argCount));
+	uInt64 capacity = 0;
+	if (argCount == 1) {
+		double num = nativeDetail::Unpack<double>::get(thread, args[0], 0);
+		if (num < 1 || num != std::floor(num)) {
+			thread->nativeError(fmt::format("Channel capacity must be a positive integer, got {}.", num));
+		}
+		capacity = static_cast<uInt64>(num);
+	}
+	args[-1] = Value(new ObjChannel(capacity));
+	return true;
+}
+
+static void checkSendable(Thread* thread, ObjChannel* channel, Value& val) {
+	if (val.isNil()) thread->nativeError("Can't send nil, it's reserved for signaling that a channel is closed.");
+	if (channel->closed.load()) thread->nativeError("Can't send to a closed channel.");
+}
+
+static void sendNative(Thread* thread, ObjChannel* channel, Value val) {
+	checkSendable(thread, channel, val);
+	if (!channel->send(thread, val)) thread->nativeError("Can't send to a closed channel.");
+}
+
+// False if the channel is full
+static bool trySendNative(Thread* thread, ObjChannel* channel, Value val) {
+	checkSendable(thread, channel, val);
+	return channel->trySend(val);
+}
+
+// Nil once the channel is closed and empty
+static Value recvNative(Thread* thread, ObjChannel* channel) {
+	Value val;
+	channel->recv(thread, val);
+	return val;
+}
+
+// Nil if the channel is empty
+static Value tryRecvNative(ObjChannel* channel) {
+	Value val;
+	channel->tryRecv(val);
+	return val;
+}
+
+// Receives from whichever channel has a value first and returns [index of the channel, value]
+// Returns nil once every channel is closed and empty
+static Value selectNative(Thread* thread, ObjArray* arr) {
+	vector<ObjChannel*> channels;
+	for (uInt64 i = 0; i < arr->values.size(); i++) {
+		Value& val = arr->values[i];
+		if (!val.isChannel()) {
+			thread->nativeError(fmt::format("Expected an array of channels, element {} is {}.", i, val.typeToStr()));
+		}
+		channels.push_back(val.asChannel());
+	}
+	if (channels.empty()) thread->nativeError("Expected at least 1 channel.");
+
+	// Starting from a different channel every time keeps one busy channel from starving the others
+	static std::atomic<uInt64> rotation = 0;
+	uInt64 start = rotation.fetch_add(1, std::memory_order_relaxed);
+	Value received;
+	int64_t index = -1;
+	// True if something was received or there is nothing left to wait for
+	auto tryAll = [&]() {
+		bool allClosed = true;
+		for (uInt64 i = 0; i < channels.size(); i++) {
+			uInt64 j = (start + i) % channels.size();
+			if (channels[j]->tryRecv(received)) {
+				index = j;
+				return true;
+			}
+			allClosed &= channels[j]->closed.load();
+		}
+		// Something could have been sent right before the last channel was closed
+		return allClosed && std::none_of(channels.begin(), channels.end(), [](ObjChannel* ch) { return ch->canRecv(); });
+	};
+
+	if (!tryAll()) {
+		std::unique_lock<std::mutex> lk(ObjChannel::selectMtx);
+		ObjChannel::selectWaiters.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!tryAll()) {
+			// A closed channel on its own isn't a reason to wake up, the others might still receive something
+			thread->waitOn(lk, ObjChannel::selectCv, [&] {
+				return std::any_of(channels.begin(), channels.end(), [](ObjChannel* ch) { return ch->canRecv(); })
+					|| std::all_of(channels.begin(), channels.end(), [](ObjChannel* ch) { return ch->closed.load(); });
+			});
+		}
+		ObjChannel::selectWaiters.fetch_sub(1);
+	}
+	if (index == -1) return Value::nil();
+	ObjArray* result = new ObjArray(2);
+	result->values[0] = Value(static_cast<double>(index));
+	result->values[1] = received;
+	result->numOfHeapPtr = received.isObj() ? 1 : 0;
+	return Value(result);
+}
+
+// Receivers get the values that are still queued, and nil once there are none left
+static void closeNative(ObjChannel* channel) {
+	channel->close();
+}
+
+void runtime::registerChannelNatives(NativeRegistry& registry) {
+	registry.addRaw("Channel", &channelNative, -1);
+	registry.add<sendNative>("channelSend");
+	registry.add<trySendNative>("channelTrySend");
+	registry.add<recvNative>("channelRecv");
+	registry.add<tryRecvNative>("channelTryRecv");
+	registry.add<selectNative>("channelSelect");
+	registry.add<closeNative>("channelClose");
+}
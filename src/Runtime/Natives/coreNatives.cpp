@@ -0,0 +1,36 @@
+#include "../nativeRegistry.h"
+#include <chrono>
+
+using namespace runtime;
+
+static const auto programStart = std::chrono::steady_clock::now();
+
+// Seconds since the program started, only meant for measuring time between 2 points
+static double clockNative() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - programStart).count();
+}
+
+static double sqrtNative(double num) { return std::sqrt(num); }
+static double floorNative(double num) { return std::floor(num); }
+static double ceilNative(double num) { return std::ceil(num); }
+static double absNative(double num) { return std::fabs(num); }
+
+static double lenNative(Thread* thread, Value val) {
+	if (val.isString()) return val.asString()->str.size();
+	if (val.isArray()) return val.asArray()->values.size();
+	if (val.isTypedArray()) return val.asTypedArray()->length;
+	if (val.isStringBuilder()) return val.asStringBuilder()->buffer.size();
+	if (val.isStringSlice()) return val.asStringSlice()->length;
+	if (val.isMap()) return val.asMap()->size();
+	thread->nativeError("Argument 1 must be a string, string slice, string builder, array, typed array or map, got "
+		+ val.typeToStr() + ".");
+}
+
+void runtime::registerCoreNatives(NativeRegistry& registry) {
+	registry.add<clockNative>("clock");
+	registry.add<sqrtNative>("sqrt");
+	registry.add<floorNative>("floor");
+	registry.add<ceilNative>("ceil");
+	registry.add<absNative>("abs");
+	registry.add<lenNative>("len");
+}
@@ -0,0 +1,177 @@
+#include "../nativeRegistry.h"
+#include "../../Includes/fmt/format.h"
+#include <cmath>
+#include <cstring>
+
+using namespace runtime;
+using namespace object;
+
+// Modes: "r" read, "w" write(truncates), "a" append, "m" read only through a memory mapping
+static ObjFile* openNative(Thread* thread, string path, std::string_view modeStr) {
+	FileMode mode;
+	if (modeStr == "r") mode = FileMode::READ;
+	else if (modeStr == "w") mode = FileMode::WRITE;
+	else if (modeStr == "a") mode = FileMode::APPEND;
+	else if (modeStr == "m") mode = FileMode::MAPPED;
+	else thread->nativeError(fmt::format("Unknown file mode '{}', expected one of 'r', 'w', 'a' or 'm'.", modeStr));
+	ObjFile* file = new ObjFile(path, mode);
+	if (!file->isOpen) thread->nativeError(fmt::format("Couldn't open file '{}'.", path));
+	return file;
+}
+
+static void checkReadable(Thread* thread, ObjFile* file) {
+	if (!file->isOpen) thread->nativeError(fmt::format("File '{}' is closed.", file->path));
+	if (file->mode != FileMode::READ && file->mode != FileMode::MAPPED) {
+		thread->nativeError(fmt::format("File '{}' wasn't opened for reading.", file->path));
+	}
+}
+
+// Next line without the line terminator, or nil once the whole file has been read
+// Lines of a mapped file are slices that point into the mapping
+static Value readLineNative(Thread* thread, ObjFile* file) {
+	checkReadable(thread, file);
+	if (file->mode == FileMode::MAPPED) {
+		std::string_view view = file->mappedView();
+		if (file->readPos >= view.size()) return Value::nil();
+		const char* start = view.data() + file->readPos;
+		const char* newline = static_cast<const char*>(memchr(start, '\n', view.size() - file->readPos));
+		uInt64 length = newline ? newline - start : view.size() - file->readPos;
+		uInt64 offset = file->readPos;
+		file->readPos += length + (newline ? 1 : 0);
+		if (length > 0 && start[length - 1] == '\r') length--;
+		return Value(new ObjStringSlice(file, offset, length));
+	}
+	bool success;
+	{
+		// Reading might block, the GC can run in the meantime
+		GCSafeRegion region(thread);
+		if (file->stream.rdbuf()->in_avail() <= 0) thread->waitForFd(file->pollFd, false);
+		success = static_cast<bool>(std::getline(file->stream, file->lineBuffer));
+	}
+	if (!success) return Value::nil();
+	if (!file->lineBuffer.empty() && file->lineBuffer.back() == '\r') file->lineBuffer.pop_back();
+	return Value(new ObjString(file->lineBuffer));
+}
+
+// Everything from the current position to the end of the file, read with a single call if the size is known
+// Pipes and other streams that can't seek are read in chunks until EOF
+static Value readAllNative(Thread* thread, ObjFile* file) {
+	checkReadable(thread, file);
+	if (file->mode == FileMode::MAPPED) {
+		uInt64 size = file->mappedView().size();
+		uInt64 offset = std::min(file->readPos, size);
+		file->readPos = size;
+		return Value(new ObjStringSlice(file, offset, size - offset));
+	}
+	string contents;
+	bool failed;
+	{
+		GCSafeRegion region(thread);
+		std::fstream& stream = file->stream;
+		std::streampos pos = stream.tellg();
+		std::streampos end = std::streampos(-1);
+		if (pos != std::streampos(-1)) {
+			stream.seekg(0, std::ios::end);
+			end = stream.tellg();
+			stream.clear();
+			stream.seekg(pos);
+		}
+		if (end != std::streampos(-1)) {
+			if (end > pos) {
+				contents.resize(static_cast<uInt64>(end - pos));
+				stream.read(contents.data(), contents.size());
+				contents.resize(stream.gcount());
+			}
+		}
+		else {
+			constexpr uInt64 chunkSize = 1 << 16;
+			while (stream) {
+				if (stream.rdbuf()->in_avail() <= 0) thread->waitForFd(file->pollFd, false);
+				uInt64 oldSize = contents.size();
+				contents.resize(oldSize + chunkSize);
+				stream.read(contents.data() + oldSize, chunkSize);
+				contents.resize(oldSize + stream.gcount());
+			}
+		}
+		failed = stream.bad();
+		// Hitting EOF sets failbit, later reads should just return nothing instead of failing
+		if (!failed) stream.clear();
+	}
+	if (failed) thread->nativeError(fmt::format("Failed reading from file '{}'.", file->path));
+	return Value(new ObjString(std::move(contents)));
+}
+
+// Writes the string form of 'val', output is buffered until the buffer fills up or the file is closed
+static void writeNative(Thread* thread, ObjFile* file, Value val) {
+	if (!file->isOpen) thread->nativeError(fmt::format("File '{}' is closed.", file->path));
+	if (file->mode != FileMode::WRITE && file->mode != FileMode::APPEND) {
+		thread->nativeError(fmt::format("File '{}' wasn't opened for writing.", file->path));
+	}
+	if (val.isString()) {
+		// Strings are never moved or compacted, so it's safe to keep using it while the GC runs
+		string& str = val.asString()->str;
+		GCSafeRegion region(thread);
+		thread->waitForFd(file->pollFd, true);
+		file->stream.write(str.data(), str.size());
+	}
+	else {
+		string str = val.isStringSlice() ? string(val.asStringSlice()->view()) : valueToStr(val);
+		GCSafeRegion region(thread);
+		thread->waitForFd(file->pollFd, true);
+		file->stream.write(str.data(), str.size());
+	}
+	if (!file->stream) thread->nativeError(fmt::format("Failed writing to file '{}'.", file->path));
+}
+
+static void closeNative(ObjFile* file) {
+	file->close();
+}
+
+// Iterators read 'path', or stdin if it's nil, without ever holding more than a buffer's worth of it in memory:
+// var it = fileLines(nil);
+// while (fileNext(it)) { var line = fileCurrent(it); ... }
+static ObjFileIterator* makeIterator(Thread* thread, Value& path, uInt64 chunkSize) {
+	if (!path.isNil() && !path.isString()) {
+		thread->nativeError(fmt::format("Expected a path or nil(for stdin), got {}.", path.typeToStr()));
+	}
+	string pathStr = path.isNil() ? "" : path.asString()->str;
+	ObjFileIterator* it = new ObjFileIterator(pathStr, chunkSize);
+	if (!it->source) thread->nativeError(fmt::format("Couldn't open file '{}'.", pathStr));
+	return it;
+}
+
+static ObjFileIterator* linesNative(Thread* thread, Value path) {
+	return makeIterator(thread, path, 0);
+}
+
+static ObjFileIterator* chunksNative(Thread* thread, Value path, double size) {
+	if (size < 1 || size != std::floor(size)) {
+		thread->nativeError(fmt::format("Chunk size must be a positive integer, got {}.", size));
+	}
+	return makeIterator(thread, path, static_cast<uInt64>(size));
+}
+
+static bool nextNative(Thread* thread, ObjFileIterator* it) {
+	// Doesn't touch the heap, so the GC can run while this is blocked on a read
+	// The main thread instead runs pending collections itself while it waits for input
+	GCSafeRegion region(thread);
+	return it->advance(thread);
+}
+
+// Items that aren't requested are never copied out of the iterator's buffer
+static Value currentNative(ObjFileIterator* it) {
+	if (it->current.data() == nullptr) return Value::nil();
+	return Value(new ObjString(string(it->current)));
+}
+
+void runtime::registerFileNatives(NativeRegistry& registry) {
+	registry.add<openNative>("fileOpen");
+	registry.add<readLineNative>("fileReadLine");
+	registry.add<readAllNative>("fileReadAll");
+	registry.add<writeNative>("fileWrite");
+	registry.add<closeNative>("fileClose");
+	registry.add<linesNative>("fileLines");
+	registry.add<chunksNative>("fileChunks");
+	registry.add<nextNative>("fileNext");
+	registry.add<currentNative>("fileCurrent");
+}
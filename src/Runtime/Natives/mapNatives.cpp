@@ -0,0 +1,41 @@
+#include "../nativeRegistry.h"
+
+using namespace runtime;
+using namespace object;
+
+static bool hasNative(ObjMap* map, Value key) {
+	return map->get(key) != nullptr;
+}
+
+// Returns false if the key wasn't in the map
+static bool removeNative(ObjMap* map, Value key) {
+	return map->remove(key);
+}
+
+// Iteration goes through arrays of keys or values, both are in the same order as long as the map isn't modified
+static ObjArray* keysNative(ObjMap* map) {
+	ObjArray* arr = new ObjArray();
+	arr->values.reserve(map->size());
+	map->forEach([&](ObjMap::Entry& entry) {
+		arr->values.push_back(entry.key);
+		if (entry.key.isObj()) arr->numOfHeapPtr++;
+	});
+	return arr;
+}
+
+static ObjArray* valuesNative(ObjMap* map) {
+	ObjArray* arr = new ObjArray();
+	arr->values.reserve(map->size());
+	map->forEach([&](ObjMap::Entry& entry) {
+		arr->values.push_back(entry.val);
+		if (entry.val.isObj()) arr->numOfHeapPtr++;
+	});
+	return arr;
+}
+
+void runtime::registerMapNatives(NativeRegistry& registry) {
+	registry.add<hasNative>("mapHas");
+	registry.add<removeNative>("mapRemove");
+	registry.add<keysNative>("mapKeys");
+	registry.add<valuesNative>("mapValues");
+}
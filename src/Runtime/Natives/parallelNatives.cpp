@@ -0,0 +1,71 @@
+#include "../nativeRegistry.h"
+#include "../workerPool.h"
+#include "../vm.h"
+#include "../../Includes/fmt/format.h"
+#include <cmath>
+
+using namespace runtime;
+using namespace object;
+
+// Each thread gets about this many chunks when no chunk size is given, small enough to even out uneven tasks while
+// keeping the contention on the shared counter low
+#define CHUNKS_PER_THREAD 4
+
+static uInt64 checkCount(Thread* thread, double num, const char* what) {
+	if (num < 0 || num != std::floor(num)) {
+		thread->nativeError(fmt::format("{} must be a non negative integer, got {}.", what, num));
+	}
+	return static_cast<uInt64>(num);
+}
+
+// Both natives take an optional chunk size as the 3rd argument
+static uInt64 chunkSizeArg(Thread* thread, int argCount, Value* args, uInt64 count, WorkerPool* pool) {
+	if (argCount != 2 && argCount != 3) {
+		thread->nativeError(fmt::format("Expected 2 or 3 arguments but got {}.", argCount));
+	}
+	if (argCount == 3) {
+		uInt64 chunkSize = checkCount(thread, nativeDetail::Unpack<double>::get(thread, args[2], 2), "Chunk size");
+		if (chunkSize == 0) thread->nativeError("Chunk size must be at least 1.");
+		return chunkSize;
+	}
+	return std::max<uInt64>(count / ((pool->workerCount() + 1) * CHUNKS_PER_THREAD), 1);
+}
+
+static void runJob(Thread* thread, WorkerPool* pool, ParallelJob& job, const char* name) {
+	pool->run(thread, job);
+	if (job.failed) thread->nativeError(fmt::format("{} failed at index {}: {}", name, job.errorIndex, job.error));
+}
+
+// parallelFor(n, fn[, chunkSize]), calls fn(i) for every i in [0, n) spread across the worker pool
+static bool parallelForNative(Thread* thread, int argCount, Value* args) {
+	WorkerPool* pool = thread->getVM()->getWorkerPool();
+	uInt64 count = checkCount(thread, nativeDetail::Unpack<double>::get(thread, args[0], 0), "Number of iterations");
+	uInt64 chunkSize = chunkSizeArg(thread, argCount, args, count, pool);
+	ParallelJob job(args[1], count, chunkSize, nullptr, false);
+	runJob(thread, pool, job, "parallelFor");
+	args[-1] = Value::nil();
+	return true;
+}
+
+// parallelMap(array, fn[, chunkSize]), returns a new array containing fn(array[i]) for every element
+static bool parallelMapNative(Thread* thread, int argCount, Value* args) {
+	WorkerPool* pool = thread->getVM()->getWorkerPool();
+	ObjArray* source = nativeDetail::Unpack<ObjArray*>::get(thread, args[0], 0);
+	uInt64 chunkSize = chunkSizeArg(thread, argCount, args, source->values.size(), pool);
+	// Tasks read their argument from the result array, so a task that modifies 'array' can't race with the others
+	ObjArray* results = new ObjArray(source->values.size());
+	results->values = source->values;
+	// Any element might become an object while the tasks run, so the GC has to scan all of them until it's done
+	results->numOfHeapPtr = results->values.size();
+	// The slot of the callee keeps the results alive during collections
+	args[-1] = Value(results);
+	ParallelJob job(args[1], results->values.size(), chunkSize, results, true);
+	runJob(thread, pool, job, "parallelMap");
+	results->numOfHeapPtr = std::count_if(results->values.begin(), results->values.end(), [](Value& val) { return val.isObj(); });
+	return true;
+}
+
+void runtime::registerParallelNatives(NativeRegistry& registry) {
+	registry.addRaw("parallelFor", &parallelForNative, -1);
+	registry.addRaw("parallelMap", &parallelMapNative, -1);
+}
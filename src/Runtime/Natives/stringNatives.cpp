@@ -0,0 +1,114 @@
+#include "../nativeRegistry.h"
+#include "../../Includes/fmt/format.h"
+#include <charconv>
+
+using namespace runtime;
+using namespace object;
+
+#pragma region StringBuilder
+static ObjStringBuilder* stringBuilderNative() {
+	return new ObjStringBuilder();
+}
+
+// Appends the string representation of 'val', returns the builder so that calls can be chained
+static ObjStringBuilder* appendNative(ObjStringBuilder* builder, Value val) {
+	// Strings are the common case, appending them directly avoids a temporary copy
+	if (val.isString()) builder->buffer.append(val.asString()->str);
+	else if (val.isStringSlice()) builder->buffer.append(val.asStringSlice()->view());
+	else builder->buffer.append(valueToStr(val));
+	return builder;
+}
+
+// Copies the contents into a new string, the builder can keep being appended to afterwards
+static ObjString* buildNative(ObjStringBuilder* builder) {
+	return new ObjString(builder->buffer);
+}
+
+// Empties the builder but keeps it's memory so that it can be reused
+static ObjStringBuilder* clearNative(ObjStringBuilder* builder) {
+	builder->buffer.clear();
+	return builder;
+}
+#pragma endregion
+
+#pragma region Slices
+// Slices reference the string they were taken from, taking them never copies any characters
+// Every function here accepts both strings and slices
+static ObjStringSlice* makeSlice(Value& str, uInt64 start, uInt64 length) {
+	if (str.isString()) return new ObjStringSlice(str.asString(), start, length);
+	return str.asStringSlice()->slice(start, length);
+}
+
+static void checkStringLike(Thread* thread, Value& val, int argIndex) {
+	if (!val.isString() && !val.isStringSlice()) {
+		thread->nativeError(fmt::format("Argument {} must be a string, got {}.", argIndex + 1, val.typeToStr()));
+	}
+}
+
+// Characters in [start, end)
+static ObjStringSlice* sliceNative(Thread* thread, Value str, double start, double end) {
+	checkStringLike(thread, str, 0);
+	uInt64 length = str.isString() ? str.asString()->str.size() : str.asStringSlice()->length;
+	if (!IS_INT(start) || !IS_INT(end) || start < 0 || end < start || end > length) {
+		thread->nativeError(fmt::format("Invalid slice [{}, {}) of a string with length {}.", start, end, length));
+	}
+	return makeSlice(str, static_cast<uInt64>(start), static_cast<uInt64>(end - start));
+}
+
+// Array of slices between occurrences of 'separator'
+static ObjArray* splitNative(Thread* thread, Value str, std::string_view separator) {
+	checkStringLike(thread, str, 0);
+	if (separator.empty()) thread->nativeError("Separator can't be empty.");
+	std::string_view view = str.isString() ? std::string_view(str.asString()->str) : str.asStringSlice()->view();
+	ObjArray* arr = new ObjArray();
+	uInt64 start = 0;
+	while (true) {
+		uInt64 end = view.find(separator, start);
+		if (end == std::string_view::npos) end = view.size();
+		arr->values.push_back(Value(makeSlice(str, start, end - start)));
+		if (end == view.size()) break;
+		start = end + separator.size();
+	}
+	arr->numOfHeapPtr = arr->values.size();
+	return arr;
+}
+
+// Slice without leading and trailing whitespace
+static ObjStringSlice* trimNative(Thread* thread, Value str) {
+	checkStringLike(thread, str, 0);
+	std::string_view view = str.isString() ? std::string_view(str.asString()->str) : str.asStringSlice()->view();
+	auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+	uInt64 start = 0;
+	uInt64 end = view.size();
+	while (start < end && isSpace(view[start])) start++;
+	while (end > start && isSpace(view[end - 1])) end--;
+	return makeSlice(str, start, end - start);
+}
+
+// Copies a slice into a regular string, any other value is converted to it's printed form
+static ObjString* strNative(Value val) {
+	if (val.isString()) return val.asString();
+	if (val.isStringSlice()) return new ObjString(string(val.asStringSlice()->view()));
+	return new ObjString(valueToStr(val));
+}
+
+// Parses a number without copying the string first, returns nil if the whole string isn't a number
+static Value toNumberNative(std::string_view str) {
+	double num;
+	auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), num);
+	if (ec != std::errc() || ptr != str.data() + str.size()) return Value::nil();
+	return Value(num);
+}
+#pragma endregion
+
+void runtime::registerStringNatives(NativeRegistry& registry) {
+	registry.add<stringBuilderNative>("StringBuilder");
+	registry.add<appendNative>("builderAppend");
+	registry.add<buildNative>("builderBuild");
+	registry.add<clearNative>("builderClear");
+	registry.add<sliceNative>("stringSlice");
+	registry.add<splitNative>("stringSplit");
+	registry.add<trimNative>("stringTrim");
+	registry.add<strNative>("str");
+	registry.add<toNumberNative>("toNumber");
+}
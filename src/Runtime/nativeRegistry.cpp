@@ -0,0 +1,33 @@
+#include "nativeRegistry.h"
+#include "../Includes/fmt/format.h"
+
+using namespace runtime;
+
+void nativeDetail::argTypeError(Thread* thread, int index, const char* expected, Value& got) {
+	thread->nativeError(fmt::format("Argument {} must be a {}, got {}.", index + 1, expected, got.typeToStr()));
+}
+
+const vector<NativeBinding>& runtime::nativeBindings() {
+	// Initialized once, thread safe
+	static const vector<NativeBinding> bindings = []() {
+		NativeRegistry registry;
+		registerCoreNatives(registry);
+		registerArrayNatives(registry);
+		registerStringNatives(registry);
+		registerMapNatives(registry);
+		registerFileNatives(registry);
+		registerParallelNatives(registry);
+		registerChannelNatives(registry);
+		return registry.bindings;
+	}();
+	return bindings;
+}
+
+void runtime::bindNatives(vector<Globalvar>& globals) {
+	const vector<NativeBinding>& bindings = nativeBindings();
+	for (uInt i = 0; i < bindings.size(); i++) {
+		const NativeBinding& binding = bindings[i];
+		globals[i].val = Value(new object::ObjNativeFunc(binding.func, binding.arity, binding.name));
+		globals[i].isDefined = true;
+	}
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include "thread.h"
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Natives are C++ functions callable from CSL, they occupy the first slots of the globals array(in registration order)
+// and behave like globals declared in every module: readable everywhere, shadowed by a declaration with the same name
+// Since they all share that namespace, natives that work on one kind of object are prefixed with it(fileOpen, mapKeys,
+// channelSend, arraySum...), constructors and natives that accept any value(len, str) aren't
+namespace runtime {
+	struct NativeBinding {
+		string name;
+		object::NativeFn func;
+		// -1 if the function takes a variable number of arguments
+		int arity;
+	};
+
+	namespace nativeDetail {
+		// Out of line so that the error path doesn't bloat every instantiated wrapper
+		[[noreturn]] void argTypeError(Thread* thread, int index, const char* expected, Value& got);
+
+		// Converts the argument at 'index' to T, reports a runtime error if the types don't match
+		template<typename T>
+		struct Unpack;
+
+		template<>
+		struct Unpack<Value> {
+			static Value get(Thread*, Value& val, int) { return val; }
+		};
+		template<>
+		struct Unpack<double> {
+			static double get(Thread* thread, Value& val, int index) {
+				if (!val.isNumber()) argTypeError(thread, index, "number", val);
+				return val.asNumber();
+			}
+		};
+		template<>
+		struct Unpack<bool> {
+			static bool get(Thread* thread, Value& val, int index) {
+				if (!val.isBool()) argTypeError(thread, index, "bool", val);
+				return val.asBool();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjString*> {
+			static object::ObjString* get(Thread* thread, Value& val, int index) {
+				if (!val.isString()) argTypeError(thread, index, "string", val);
+				return val.asString();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjArray*> {
+			static object::ObjArray* get(Thread* thread, Value& val, int index) {
+				if (!val.isArray()) argTypeError(thread, index, "array", val);
+				return val.asArray();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjTypedArray*> {
+			static object::ObjTypedArray* get(Thread* thread, Value& val, int index) {
+				if (!val.isTypedArray()) argTypeError(thread, index, "typed array", val);
+				return val.asTypedArray();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjMap*> {
+			static object::ObjMap* get(Thread* thread, Value& val, int index) {
+				if (!val.isMap()) argTypeError(thread, index, "map", val);
+				return val.asMap();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjFile*> {
+			static object::ObjFile* get(Thread* thread, Value& val, int index) {
+				if (!val.isFile()) argTypeError(thread, index, "file", val);
+				return val.asFile();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjFileIterator*> {
+			static object::ObjFileIterator* get(Thread* thread, Value& val, int index) {
+				if (!val.isFileIterator()) argTypeError(thread, index, "file iterator", val);
+				return val.asFileIterator();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjChannel*> {
+			static object::ObjChannel* get(Thread* thread, Value& val, int index) {
+				if (!val.isChannel()) argTypeError(thread, index, "channel", val);
+				return val.asChannel();
+			}
+		};
+		template<>
+		struct Unpack<object::ObjStringBuilder*> {
+			static object::ObjStringBuilder* get(Thread* thread, Value& val, int index) {
+				if (!val.isStringBuilder()) argTypeError(thread, index, "string builder", val);
+				return val.asStringBuilder();
+			}
+		};
+		// Accepts both strings and string slices, the view is valid until the native returns
+		template<>
+		struct Unpack<std::string_view> {
+			static std::string_view get(Thread* thread, Value& val, int index) {
+				if (val.isString()) return val.asString()->str;
+				if (!val.isStringSlice()) argTypeError(thread, index, "string", val);
+				return val.asStringSlice()->view();
+			}
+		};
+		// Copies the string, prefer ObjString* for anything that is called often
+		template<>
+		struct Unpack<string> {
+			static string get(Thread* thread, Value& val, int index) {
+				return Unpack<object::ObjString*>::get(thread, val, index)->str;
+			}
+		};
+
+		template<typename T>
+		Value toValue(T&& result) {
+			using R = std::remove_cvref_t<T>;
+			if constexpr (std::is_same_v<R, Value> || std::is_same_v<R, bool>) return Value(result);
+			else if constexpr (std::is_arithmetic_v<R>) return Value(static_cast<double>(result));
+			else if constexpr (std::is_same_v<R, string>) return Value(new object::ObjString(result));
+			else return Value(static_cast<object::Obj*>(result));
+		}
+
+		template<typename... Args>
+		constexpr bool takesThread = false;
+		template<typename... Args>
+		constexpr bool takesThread<Thread*, Args...> = true;
+
+		template<auto Fn, typename Sig = decltype(Fn)>
+		struct Wrapper;
+
+		// Generates a plain NativeFn for 'Fn', arity is checked by the VM before the call so the arguments
+		// only need their types checked
+		template<auto Fn, typename R, typename... Args>
+		struct Wrapper<Fn, R(*)(Args...)> {
+			static constexpr bool passThread = takesThread<Args...>;
+			static constexpr int arity = sizeof...(Args) - (passThread ? 1 : 0);
+			template<size_t I>
+			using Arg = std::remove_cvref_t<std::tuple_element_t<I + (passThread ? 1 : 0), std::tuple<Args...>>>;
+
+			// The argument count always equals 'arity' here
+			static bool call(Thread* thread, int, Value* args) {
+				return callImpl(thread, args, std::make_index_sequence<arity>{});
+			}
+
+			template<size_t... I>
+			static bool callImpl(Thread* thread, Value* args, std::index_sequence<I...>) {
+				// Braced initialization unpacks left to right, so the first mismatched argument is the one reported
+				std::tuple<Arg<I>...> unpacked{ Unpack<Arg<I>>::get(thread, args[I], I)... };
+				auto invoke = [&]() -> R {
+					if constexpr (passThread) return Fn(thread, std::get<I>(unpacked)...);
+					else return Fn(std::get<I>(unpacked)...);
+				};
+				// The result goes in the slot of the callee, the VM pops the arguments after this returns
+				if constexpr (std::is_void_v<R>) {
+					invoke();
+					args[-1] = Value::nil();
+				}
+				else args[-1] = toValue(invoke());
+				return true;
+			}
+		};
+	}
+
+	class NativeRegistry {
+	public:
+		// Registers a function that works with the stack directly, see object::NativeFn for the calling convention
+		void addRaw(string name, object::NativeFn func, int arity) {
+			bindings.push_back(NativeBinding{ name, func, arity });
+		}
+		// Registers a C++ function, arguments are unpacked from their types(Value, double, bool, string, ObjString*,
+		// string_view, ObjArray*, ObjTypedArray*, ObjMap*, ObjStringBuilder*, ObjFile*,
+		// ObjFileIterator*, ObjChannel*) and the result is converted back into a Value, a leading Thread* parameter receives the calling thread
+		template<auto Fn>
+		void add(string name) {
+			using W = nativeDetail::Wrapper<Fn>;
+			addRaw(name, &W::call, W::arity);
+		}
+
+		vector<NativeBinding> bindings;
+	};
+
+	// Natives that don't touch the heap can let the GC run while they're executing(eg. while blocking on IO),
+	// the thread counts as paused for the lifetime of this object
+	// Arguments stay valid since they're on the stack and the GC doesn't move objects, but nothing may be allocated
+	// or mutated until the region is left(views into string slices must be taken again, the GC may compact them)
+	class GCSafeRegion {
+	public:
+		GCSafeRegion(Thread* _thread) : thread(_thread) { thread->enterGCSafeRegion(); }
+		~GCSafeRegion() { thread->leaveGCSafeRegion(); }
+		GCSafeRegion(const GCSafeRegion&) = delete;
+		GCSafeRegion& operator=(const GCSafeRegion&) = delete;
+	private:
+		Thread* thread;
+	};
+
+	// Every native, built once in a fixed order so that the compiler and the VM agree on global indices
+	const vector<NativeBinding>& nativeBindings();
+	// Fills the first nativeBindings().size() slots of 'globals' with native function objects
+	void bindNatives(vector<Globalvar>& globals);
+
+	void registerCoreNatives(NativeRegistry& registry);
+	void registerArrayNatives(NativeRegistry& registry);
+	void registerStringNatives(NativeRegistry& registry);
+	void registerMapNatives(NativeRegistry& registry);
+	void registerFileNatives(NativeRegistry& registry);
+	void registerParallelNatives(NativeRegistry& registry);
+	void registerChannelNatives(NativeRegistry& registry);
+}
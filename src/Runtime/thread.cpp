@@ -4,19 +4,26 @@
 #include <utility>
 #include "../Includes/fmt/format.h"
 #include "../Includes/fmt/color.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#endif
 
 using std::get;
 
 runtime::Thread::Thread(VM* _vm) {
     stackTop = stack;
     frameCount = 0;
+    callBase = -1;
+    exitCode = 0;
     vm = _vm;
 }
 // Copies the callee and all arguments, otherStack points to the callee, arguments are on top of it on the stack
 void runtime::Thread::startThread(Value* otherStack, int num) {
     memcpy(stackTop, otherStack, sizeof(Value) * num);
     stackTop += num;
-    callValue(*otherStack, num - 1);
+    // Natives are called once the thread starts executing, calling them here would run them on the caller's thread
+    if (!otherStack->isNativeFn()) callValue(*otherStack, num - 1);
 }
 
 // Copies value to the stack
@@ -55,6 +62,127 @@ void runtime::Thread::runtimeError(string err, int errorCode) {
     throw errorCode;
 }
 
+void runtime::Thread::nativeError(string msg) {
+    runtimeError(fmt::format("Error: {}", msg), 3);
+}
+
+bool runtime::Thread::isMainThread() {
+    // The main thread has nil instead of a future in it's first slot
+    return stack[0].isNil();
+}
+
+void runtime::Thread::pauseForCollection() {
+    // Notify the main thread that this one is paused, the main thread sends the notification when to awaken
+    {
+        std::lock_guard<std::mutex> lk(vm->pauseMtx);
+        vm->threadsPaused.fetch_add(1);
+    }
+    // Only the main thread waits for mainThreadCv
+    vm->mainThreadCv.notify_one();
+
+    // No need to propagate this since the main thread won't be listening
+    std::unique_lock lk(vm->pauseMtx);
+    vm->childThreadsCv.wait(lk, [] { return !memory::gc.shouldCollect.load(); });
+    vm->threadsPaused.fetch_sub(1);
+}
+
+void runtime::Thread::collectGarbage() {
+    if (vm->allThreadsPaused()) {
+        memory::gc.collect(vm);
+        return;
+    }
+    // If some threads aren't sleeping yet, use a cond var to wait, every child thread will notify the var when it goes to sleep
+    std::unique_lock lk(vm->pauseMtx);
+    vm->mainThreadCv.wait(lk, [&] { return vm->allThreadsPaused(); });
+    // Release the mutex here so that GC can acquire it
+    lk.unlock();
+    // After all threads are asleep, run the GC and subsequently awaken all child threads
+    memory::gc.collect(vm);
+}
+
+void runtime::Thread::enterGCSafeRegion() {
+    // The main thread is the one that runs the GC, so it never waits for itself
+    if (isMainThread()) return;
+    {
+        std::lock_guard<std::mutex> lk(vm->pauseMtx);
+        vm->threadsPaused.fetch_add(1);
+    }
+    vm->mainThreadCv.notify_one();
+}
+
+void runtime::Thread::leaveGCSafeRegion() {
+    if (isMainThread()) return;
+    vm->threadsPaused.fetch_sub(1);
+    // If the main thread saw this thread as paused it might be collecting right now, which has to finish
+    // before this thread touches the heap again
+    if (memory::gc.shouldCollect.load()) pauseForCollection();
+}
+
+void runtime::Thread::waitForFd(int fd, bool forWrite) {
+    #ifndef _WIN32
+    if (!isMainThread() || fd < 0) return;
+    pollfd pfd = { fd, static_cast<short>(forWrite ? POLLOUT : POLLIN), 0 };
+    while (true) {
+        int ready = poll(&pfd, 1, static_cast<int>(GC_POLL_INTERVAL.count()));
+        if (ready > 0 || (ready < 0 && errno != EINTR)) return;
+        if (memory::gc.shouldCollect.load()) collectGarbage();
+    }
+    #endif
+}
+
+Value runtime::Thread::callFunction(Value callee, Value* args, int argCount) {
+    Value* savedTop = stackTop;
+    int savedFrameCount = frameCount;
+    int savedBase = callBase;
+    try {
+        push(callee);
+        for (int i = 0; i < argCount; i++) push(args[i]);
+        callBase = frameCount;
+        callValue(callee, argCount);
+        // Natives and classes without a constructor are done right away, everything else needs to be executed
+        if (frameCount > callBase) executeBytecode();
+    }
+    catch (int) {
+        stackTop = savedTop;
+        frameCount = savedFrameCount;
+        callBase = savedBase;
+        throw;
+    }
+    callBase = savedBase;
+    // The result is left in the slot of the callee
+    return pop();
+}
+
+static void deleteThread(object::ObjFuture* _fut, runtime::VM* vm) {
+    std::scoped_lock<std::mutex> lk(vm->mtx);
+    // Immediately delete the thread object to conserve memory
+    for (auto it = vm->childThreads.begin(); it != vm->childThreads.end(); it++) {
+        if (*it == _fut->thread) {
+            delete* it;
+            _fut->thread = nullptr;
+            vm->childThreads.erase(it);
+            break;
+        }
+    }
+}
+
+// A native started with async is the only thing such a thread executes
+void runtime::Thread::runAsyncNative(object::ObjFuture* fut) {
+    try {
+        fut->val = callFunction(stack[1], stack + 2, stackTop - stack - 2);
+    }
+    catch (int errCode) {
+        std::cout << fmt::format("{} \n{}\n", fmt::styled("Runtime error: ", fmt::fg(fmt::color::red)), errorString);
+        fmt::print("\nExited with code: {}\n", errCode);
+    }
+    std::condition_variable& cv = vm->mainThreadCv;
+    {
+        std::scoped_lock<std::mutex> lk(vm->pauseMtx);
+        deleteThread(fut, vm);
+    }
+    cv.notify_one();
+}
+
 static bool isFalsey(Value value) {
     return ((value.isBool() && !get<bool>(value.value)) || value.isNil());
 }
@@ -71,24 +199,10 @@ void runtime::Thread::callValue(Value callee, int argCount) {
                 runtimeError(fmt::format("Expected {} arguments for function call but got {}.", arity, argCount), 2);
             }
             object::NativeFn native = callee.asNativeFn()->func;
-            //native functions throw strings when a error has occured
-            try {
-                //fiber ptr is passes because a native function might create a new callstack or mutate the stack
-                bool shouldPop = native(this, argCount, stackTop - argCount);
-                //shouldPop is false if the native function already popped it's arguments(eg. if a native created a new callframe)
-                if (shouldPop) {
-                    //right now the result of the native function sits above the arguments, so we first take the result
-                    Value top = pop();
-                    //pop the args + native function itself
-                    stackTop -= argCount + 1;
-                    //push the result of the native function back on top
-                    push(top);
-                }
-            }
-            catch (string str) {
-                //globals are guaranteed not to change after the native funcs have been defined
-                runtimeError(fmt::format("Error: {}", str), 3);
-            }
+            //the thread is passed because a native function might create a new callstack or mutate the stack
+            //errors unwind through nativeError, so there is nothing to catch here
+            //the result is stored in the slot of the callee, so popping the arguments leaves it on top
+            if (native(this, argCount, stackTop - argCount)) stackTop -= argCount;
             return;
         }
         case object::ObjType::CLASS: {
@@ -194,8 +308,10 @@ void runtime::Thread::executeBytecode() {
 #ifdef DEBUG_TRACE_EXECUTION
     std::cout << "-------------Code execution starts-------------\n";
 #endif // DEBUG_TRACE_EXECUTION
-    // If this is the main thread fut will be nullptr
-    object::ObjFuture* fut = stack[0].asFuture();
+    // If this is the main thread or a worker thread fut will be nullptr
+    object::ObjFuture* fut = stack[0].isFuture() ? stack[0].asFuture() : nullptr;
+    // Only threads started with async on a native have no frames at this point, see startThread
+    if (frameCount == 0) return runAsyncNative(fut);
     // C++ is more likely to put these locals in registers which speeds things up
     CallFrame* frame = &frames[frameCount - 1];
     byte* ip = &vm->code.bytecode[frame->closure->func->bytecodeOffset];
@@ -220,18 +336,20 @@ void runtime::Thread::executeBytecode() {
             runtimeError(fmt::format("Index {} outside of range [0, {}].", (uInt64)index, callee.asArray()->values.size() - 1), 4);
         return static_cast<uInt64>(index);
     };
-    auto deleteThread = [](object::ObjFuture* _fut, VM* vm) {
-        std::scoped_lock<std::mutex> lk(vm->mtx);
-        // Immediately delete the thread object to conserve memory
-        for (auto it = vm->childThreads.begin(); it != vm->childThreads.end(); it++) {
-            if (*it == _fut->thread) {
-                delete* it;
-                _fut->thread = nullptr;
-                vm->childThreads.erase(it);
-                break;
-            }
+    auto checkTypedArrayIndex = [&](Value field, object::ObjTypedArray* arr) {
+        if (!field.isNumber()) runtimeError(fmt::format("Index must be a number, got {}.", field.typeToStr()), 3);
+        double index = field.asNumber();
+        if (!(index >= 0 && index < arr->length)) {
+            runtimeError(fmt::format("Index {} outside of range [0, {}).", index, arr->length), 4);
         }
+        if (!IS_INT(index)) runtimeError("Expected integer, got float.", 3);
+        return static_cast<uInt64>(index);
     };
+    // Doesn't go through Value::isTypedArray since this is checked on every GET/SET
+#define AS_TYPED_ARRAY(val) ((val).isObj() && (val).asObj()->type == object::ObjType::TYPED_ARRAY \
+    ? static_cast<object::ObjTypedArray*>((val).asObj()) : nullptr)
+#define AS_MAP(val) ((val).isObj() && (val).asObj()->type == object::ObjType::MAP \
+    ? static_cast<object::ObjMap*>((val).asObj()) : nullptr)
 
     // Stores the ip to the current frame before a new one is pushed
 #define STORE_FRAME() frame->ip = ip
@@ -270,36 +388,13 @@ void runtime::Thread::executeBytecode() {
     try {
     loop:
 #pragma region Multithreading
-        if (!fut && memory::gc.shouldCollect.load()) {
-            // If fut is null, this is the main thread of execution which runs the GC
-            if (vm->allThreadsPaused()) {
-                memory::gc.collect(vm);
-            }
-            else {
-                // If some threads aren't sleeping yet, use a cond var to wait, every child thread will notify the var when it goes to sleep
-                std::unique_lock lk(vm->pauseMtx);
-                vm->mainThreadCv.wait(lk, [&] { return vm->allThreadsPaused(); });
-                // Release the mutex here so that GC can acquire it
-                lk.unlock();
-                // After all threads are asleep, run the GC and subsequently awaken all child threads
-                memory::gc.collect(vm);
-            }
+        if (memory::gc.shouldCollect.load() && isMainThread()) {
+            // The main thread of execution runs the GC
+            collectGarbage();
         }
-        else if (fut && memory::gc.shouldCollect.load()) {
-            // If this is a child thread and the GC must run, notify the main thread that this one is paused
-            // Main thread sends the notification when to awaken
-            {
-                std::lock_guard<std::mutex> lk(vm->pauseMtx);
-                vm->threadsPaused.fetch_add(1);
-            }
-            // Only the main thread waits for mainThreadCv
-            vm->mainThreadCv.notify_one();
-
-            // No need to propagate this since the main thread won't be listening
-            std::unique_lock lk(vm->pauseMtx);
-            vm->childThreadsCv.wait(lk, [] { return !memory::gc.shouldCollect.load(); });
-            vm->threadsPaused.fetch_sub(1);
-            lk.unlock();
+        else if (memory::gc.shouldCollect.load()) {
+            // If this is a child thread and the GC must run, sleep until the main thread is done collecting
+            pauseForCollection();
         }
 #pragma endregion
 #ifdef DEBUG_TRACE_EXECUTION
@@ -438,6 +533,12 @@ void runtime::Thread::executeBytecode() {
             }
             case 4: {
                 Value inst = pop();
+                object::ObjString* str = READ_STRING();
+                if (object::ObjMap* map = AS_MAP(inst)) {
+                    Value* num = map->get(Value(str));
+                    if (!num) runtimeError(fmt::format("Key '{}' doesn't exist.", str->str), 4);
+                    INCREMENT(*num);
+                }
                 if (!inst.isInstance()) {
                     runtimeError(
                         fmt::format("Only instances/structs have properties, got {}.", inst.typeToStr()),
@@ -445,7 +546,6 @@ void runtime::Thread::executeBytecode() {
                 }
 
                 object::ObjInstance* instance = inst.asInstance();
-                object::ObjString* str = READ_STRING();
                 auto it = instance->fields.find(str->str);
                 if (it == instance->fields.end()) {
                     runtimeError(fmt::format("Field '{}' doesn't exist.", str->str), 4);
@@ -455,6 +555,12 @@ void runtime::Thread::executeBytecode() {
             }
             case 5: {
                 Value inst = pop();
+                object::ObjString* str = READ_STRING_LONG();
+                if (object::ObjMap* map = AS_MAP(inst)) {
+                    Value* num = map->get(Value(str));
+                    if (!num) runtimeError(fmt::format("Key '{}' doesn't exist.", str->str), 4);
+                    INCREMENT(*num);
+                }
                 if (!inst.isInstance()) {
                     runtimeError(
                         fmt::format("Only instances/structs have properties, got {}.", inst.typeToStr()),
@@ -462,7 +568,6 @@ void runtime::Thread::executeBytecode() {
                 }
 
                 object::ObjInstance* instance = inst.asInstance();
-                object::ObjString* str = READ_STRING_LONG();
 
                 auto it = instance->fields.find(str->str);
                 if (it == instance->fields.end()) {
@@ -474,6 +579,18 @@ void runtime::Thread::executeBytecode() {
             case 6: {
                 Value field = pop();
                 Value callee = pop();
+                if (object::ObjTypedArray* arr = AS_TYPED_ARRAY(callee)) {
+                    uInt64 index = checkTypedArrayIndex(field, arr);
+                    Value num = Value(arr->get(index));
+                    tryIncrement(num);
+                    arr->set(index, num.asNumber());
+                    DISPATCH();
+                }
+                if (object::ObjMap* map = AS_MAP(callee)) {
+                    Value* num = map->get(field);
+                    if (!num) runtimeError(fmt::format("Key '{}' doesn't exist.", valueToStr(field)), 4);
+                    INCREMENT(*num);
+                }
                 if (!callee.isArray() && !callee.isInstance())
                     runtimeError(fmt::format("Expected a array or struct, got {}.", callee.typeToStr()), 3);
 
@@ -524,6 +641,18 @@ void runtime::Thread::executeBytecode() {
 
                 push(Value(a->concat(b)));
             }
+            else if ((peek(0).isString() || peek(0).isStringSlice()) && (peek(1).isString() || peek(1).isStringSlice())) {
+                // Concatenating slices always produces a regular string
+                auto view = [](Value val) -> std::string_view {
+                    return val.isString() ? std::string_view(val.asString()->str) : val.asStringSlice()->view();
+                };
+                std::string_view b = view(pop());
+                std::string_view a = view(pop());
+                string temp;
+                temp.reserve(a.size() + b.size());
+                temp.append(a).append(b);
+                push(Value(new object::ObjString(std::move(temp))));
+            }
             else {
                 runtimeError(fmt::format("Operands must be two numbers or two strings, got {} and {}.",
                     peek(1).typeToStr(), peek(0).typeToStr()), 3);
@@ -780,9 +909,46 @@ void runtime::Thread::executeBytecode() {
             DISPATCH();
         }
 
+        case +OpCode::TAIL_CALL: {
+            int argCount = READ_BYTE();
+            Value callee = peek(argCount);
+            object::ObjClosure* closure = nullptr;
+            if (callee.isClosure()) closure = callee.asClosure();
+            else if (callee.isBoundMethod()) {
+                //puts the receiver instance in the 0th slot of the frame('this' points to the 0th slot)
+                object::ObjBoundMethod* bound = callee.asBoundMethod();
+                stackTop[-argCount - 1] = bound->receiver;
+                closure = bound->method;
+            }
+            // Natives and class constructors get a regular call, the RETURN emitted after this op returns the result
+            if (closure == nullptr) {
+                STORE_FRAME();
+                callValue(callee, argCount);
+                LOAD_FRAME();
+                DISPATCH();
+            }
+            if (argCount != closure->func->arity) {
+                runtimeError(fmt::format("Expected {} arguments for function call but got {}.", closure->func->arity, argCount), 2);
+            }
+            // Slide the callee and arguments down to the start of the current frame, locals of the current function are discarded
+            // Captured locals live in ObjUpval objects, so overwriting their stack slots is safe
+            memmove(slotStart, stackTop - argCount - 1, sizeof(Value) * (argCount + 1));
+            stackTop = slotStart + argCount + 1;
+            frame->closure = closure;
+            frame->ip = &vm->code.bytecode[closure->func->bytecodeOffset];
+            LOAD_FRAME();
+            DISPATCH();
+        }
+
         case +OpCode::RETURN: {
             Value result = pop();
             frameCount--;
+            // Returning from a function called by a native through callFunction
+            if (frameCount == callBase) {
+                stackTop = slotStart;
+                push(result);
+                return;
+            }
             // If we're returning from the implicit function
             if (frameCount == 0) {
                 // Main thread doesn't have a future nor does it need to delete the thread
@@ -863,11 +1029,23 @@ void runtime::Thread::executeBytecode() {
         }
 
         case +OpCode::AWAIT: {
-            Value val = pop();
+            // Stays on the stack while waiting so that a collection can't free it
+            Value val = peek(0);
             if (!val.isFuture())
                 runtimeError(fmt::format("Await can only be applied to a future, got {}", val.typeToStr()), 3);
             object::ObjFuture* futToAwait = val.asFuture();
-            futToAwait->fut.wait();
+            // The awaited thread might need a collection to finish, so waiting can't stall the GC
+            if (isMainThread()) {
+                while (futToAwait->fut.wait_for(GC_POLL_INTERVAL) != std::future_status::ready) {
+                    if (memory::gc.shouldCollect.load()) collectGarbage();
+                }
+            }
+            else {
+                enterGCSafeRegion();
+                futToAwait->fut.wait();
+                leaveGCSafeRegion();
+            }
+            pop();
             // Immediately delete the thread object to conserve memory
             deleteThread(futToAwait, vm);
             // Can safely access fut->val from this thread since the value is being read and won't be written to again
@@ -894,12 +1072,34 @@ void runtime::Thread::executeBytecode() {
             DISPATCH();
         }
 
+        case +OpCode::CREATE_MAP: {
+            uInt64 size = READ_BYTE();
+            auto* map = new object::ObjMap();
+            // Key-value pairs are on the stack in the order they were written in
+            Value* entries = stackTop - size * 2;
+            for (uInt64 i = 0; i < size; i++) map->set(entries[i * 2], entries[i * 2 + 1]);
+            stackTop = entries;
+            push(Value(map));
+            DISPATCH();
+        }
+
         case +OpCode::GET: {
             //structs and objects also get their own +OpCode::GET_PROPERTY operator for access using '.'
             //use peek because in case this is a get call to a instance that has a defined "access" method
             //we want to use these 2 values as args and receiver
             Value field = pop();
             Value callee = pop();
+            // Typed arrays come first since they're used in hot numeric loops
+            if (object::ObjTypedArray* arr = AS_TYPED_ARRAY(callee)) {
+                push(Value(arr->get(checkTypedArrayIndex(field, arr))));
+                DISPATCH();
+            }
+            // Missing keys read as nil
+            if (object::ObjMap* map = AS_MAP(callee)) {
+                Value* val = map->get(field);
+                push(val ? *val : Value::nil());
+                DISPATCH();
+            }
             if (!callee.isArray() && !callee.isInstance())
                 runtimeError(fmt::format("Expected a array or struct, got {}.", callee.typeToStr()), 3);
 
@@ -934,6 +1134,16 @@ void runtime::Thread::executeBytecode() {
             Value callee = pop();
             Value val = peek(0);
 
+            if (object::ObjTypedArray* arr = AS_TYPED_ARRAY(callee)) {
+                uInt64 index = checkTypedArrayIndex(field, arr);
+                if (!val.isNumber()) runtimeError(fmt::format("Typed arrays can only hold numbers, got {}.", val.typeToStr()), 3);
+                arr->set(index, val.asNumber());
+                DISPATCH();
+            }
+            if (object::ObjMap* map = AS_MAP(callee)) {
+                map->set(field, val);
+                DISPATCH();
+            }
             if (!callee.isArray() && !callee.isInstance())
                 runtimeError(fmt::format("Expected a array or struct, got {}.", callee.typeToStr()), 3);
             if (callee.asObj()->type == object::ObjType::ARRAY) {
@@ -963,12 +1173,18 @@ void runtime::Thread::executeBytecode() {
 
         case +OpCode::GET_PROPERTY: {
             Value inst = pop();
+            object::ObjString* name = READ_STRING();
+            // map["key"] is compiled to a property access as well, missing keys read as nil
+            if (object::ObjMap* map = AS_MAP(inst)) {
+                Value* val = map->get(Value(name));
+                push(val ? *val : Value::nil());
+                DISPATCH();
+            }
             if (!inst.isInstance()) {
                 runtimeError(fmt::format("Only instances/structs have properties, got {}.", inst.typeToStr()), 3);
             }
 
             object::ObjInstance* instance = inst.asInstance();
-            object::ObjString* name = READ_STRING();
 
             auto it = instance->fields.find(name->str);
             if (it != instance->fields.end()) {
@@ -985,12 +1201,18 @@ void runtime::Thread::executeBytecode() {
         }
         case +OpCode::GET_PROPERTY_LONG: {
             Value inst = pop();
+            object::ObjString* name = READ_STRING_LONG();
+            // map["key"] is compiled to a property access as well, missing keys read as nil
+            if (object::ObjMap* map = AS_MAP(inst)) {
+                Value* val = map->get(Value(name));
+                push(val ? *val : Value::nil());
+                DISPATCH();
+            }
             if (!inst.isInstance()) {
                 runtimeError(fmt::format("Only instances/structs have properties, got {}.", inst.typeToStr()), 3);
             }
 
             object::ObjInstance* instance = inst.asInstance();
-            object::ObjString* name = READ_STRING_LONG();
 
             auto it = instance->fields.find(name->str);
             if (it != instance->fields.end()) {
@@ -1008,24 +1230,34 @@ void runtime::Thread::executeBytecode() {
 
         case +OpCode::SET_PROPERTY: {
             Value inst = pop();
+            object::ObjString* name = READ_STRING();
+            if (object::ObjMap* map = AS_MAP(inst)) {
+                map->set(Value(name), peek(0));
+                DISPATCH();
+            }
             if (!inst.isInstance()) {
                 runtimeError(fmt::format("Only instances/structs have properties, got {}.", inst.typeToStr()), 3);
             }
             object::ObjInstance* instance = inst.asInstance();
 
             //we don't care if we're overriding or creating a new field
-            instance->fields.insert_or_assign(READ_STRING()->str, peek(0));
+            instance->fields.insert_or_assign(name->str, peek(0));
             DISPATCH();
         }
         case +OpCode::SET_PROPERTY_LONG: {
             Value inst = pop();
+            object::ObjString* name = READ_STRING_LONG();
+            if (object::ObjMap* map = AS_MAP(inst)) {
+                map->set(Value(name), peek(0));
+                DISPATCH();
+            }
             if (!inst.isInstance()) {
                 runtimeError(fmt::format("Only instances/structs have properties, got {}.", inst.typeToStr()), 3);
             }
             object::ObjInstance* instance = inst.asInstance();
 
             //we don't care if we're overriding or creating a new field
-            instance->fields.insert_or_assign(READ_STRING_LONG()->str, peek(0));
+            instance->fields.insert_or_assign(name->str, peek(0));
             DISPATCH();
         }
 
@@ -1138,6 +1370,9 @@ void runtime::Thread::executeBytecode() {
     }
     catch (int errCode) {
         frame->ip = ip;
+        // Errors inside of callFunction are handled by the native that called it
+        if (callBase != -1) throw;
+        exitCode = errCode;
         auto cyan = fmt::fg(fmt::color::cyan);
         auto white = fmt::fg(fmt::color::white);
         auto red = fmt::fg(fmt::color::red);
@@ -1150,10 +1385,11 @@ void runtime::Thread::executeBytecode() {
             // Converts ip from a pointer to a index in the array
             uInt64 instruction = (frame->ip - 1) - vm->code.bytecode.data();
             codeLine line = vm->code.getLine(instruction);
-            //fileName:line | in <func name>
-            std::cout << fmt::format("{}:{} | in {}\n",
+            //fileName:line:column | in <func name>
+            std::cout << fmt::format("{}:{}:{} | in {}\n",
                 fmt::styled(line.getFileName(vm->sourceFiles), yellow),
                 fmt::styled(std::to_string(line.line + 1), cyan),
+                fmt::styled(std::to_string(line.column + 1), cyan),
                 (function->name.length() == 0 ? "script" : function->name));
         }
         fmt::print("\nExited with code: {}\n", errCode);
@@ -1164,6 +1400,8 @@ void runtime::Thread::executeBytecode() {
 #undef READ_CONSTANT_LONG
 #undef READ_STRING
 #undef READ_STRING_LONG
+#undef AS_TYPED_ARRAY
+#undef AS_MAP
 #undef BINARY_OP
 #undef INT_BINARY_OP
 }
@@ -1,6 +1,13 @@
 #pragma once
-#include "../codegen/codegenDefs.h"
+#include "../Codegen/codegenDefs.h"
 #include "../Objects/objects.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// How often the main thread checks for a pending collection while it's blocked on something other threads might need
+// a collection to produce
+#define GC_POLL_INTERVAL std::chrono::milliseconds(1)
 
 namespace runtime {
 	class VM;
@@ -12,6 +19,53 @@ namespace runtime {
 		void startThread(Value* otherStack, int num);
 		void mark(memory::GarbageCollector* gc);
 		void copyVal(Value val);
+
+		// Used by natives to report errors, unwinds the thread like any other runtime error
+		[[noreturn]] void nativeError(string msg);
+		// While inside a GC safe region the thread counts as paused, see runtime::GCSafeRegion
+		void enterGCSafeRegion();
+		void leaveGCSafeRegion();
+		bool isMainThread();
+
+		// Waits on 'cv'(with 'lk' locked) until 'ready' returns true. Child threads count as paused while waiting and
+		// the main thread keeps running collections requested by other threads, so a blocked thread never stalls the GC
+		// 'ready' might be checked while a collection is running, so it must not modify anything. It might not hold
+		// anymore once this returns, callers retry their operation in a loop
+		template<typename Pred>
+		void waitOn(std::unique_lock<std::mutex>& lk, std::condition_variable& cv, Pred ready) {
+			if (isMainThread()) {
+				// Child threads that want a collection can't notify 'cv', so the main thread checks every now and then
+				while (!cv.wait_for(lk, GC_POLL_INTERVAL, ready)) {
+					if (!memory::gc.shouldCollect.load()) continue;
+					lk.unlock();
+					collectGarbage();
+					lk.lock();
+				}
+				return;
+			}
+			lk.unlock();
+			enterGCSafeRegion();
+			lk.lock();
+			cv.wait(lk, ready);
+			// Leaving the region might pause this thread, which mustn't happen while holding a lock other threads need
+			lk.unlock();
+			leaveGCSafeRegion();
+			lk.lock();
+		}
+
+		// Blocks until 'fd' can be read from(or written to if 'forWrite') without blocking, for the same reason as waitOn
+		// Only the main thread waits here, child threads block on the read or write itself inside a GC safe region
+		// Errors and hangups return right away, they're reported by the read or write that follows
+		void waitForFd(int fd, bool forWrite);
+
+		// Calls 'callee' with 'argCount' arguments and runs it to completion on this thread, used by natives that call
+		// back into CSL. Runtime errors aren't printed, they propagate to the caller(see getError) and leave the stack
+		// as it was before the call
+		Value callFunction(Value callee, Value* args, int argCount);
+		const string& getError() const { return errorString; }
+		// Code of the runtime error that stopped this thread, 0 if it ran to completion
+		int getExitCode() const { return exitCode; }
+		VM* getVM() { return vm; }
 	private:
 		Value stack[STACK_MAX];
 		Value* stackTop;
@@ -20,12 +74,22 @@ namespace runtime {
 
 		VM* vm;
 		string errorString;
+		int exitCode;
+		// Frame count at which executeBytecode hands the result back to callFunction, -1 outside of callFunction
+		int callBase;
 
 		void push(Value val);
 		Value pop();
 		Value peek(int depth);
 
-		void runtimeError(string err, int errorCode);
+		[[noreturn]] void runtimeError(string err, int errorCode);
+
+		// Called by child threads, blocks until the collection requested by the GC is done
+		void pauseForCollection();
+		// Called by the main thread, waits for every child thread to pause and runs the GC
+		void collectGarbage();
+
+		void runAsyncNative(object::ObjFuture* fut);
 
 		void callValue(Value callee, int argCount);
 		void call(object::ObjClosure* function, int argCount);
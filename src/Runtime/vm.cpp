@@ -1,17 +1,33 @@
 #include "vm.h"
-#include "../codegen/compiler.h"
+#include "../Codegen/compiler.h"
+#include "nativeRegistry.h"
+#include "workerPool.h"
 
 using std::get;
 
 runtime::VM::VM(compileCore::Compiler* compiler) {
 	globals = compiler->globals;
+	bindNatives(globals);
 	// For stack tracing during error printing
 	sourceFiles = compiler->sourceFiles;
-	// Have to do this before assigning compiler->mainCodeBlock to code because endFuncDecl mutates mainCodeBlock
-	Value val = Value(new object::ObjClosure(compiler->mainBlockFunc));
 	// Main code block
 	code = compiler->mainCodeBlock;
+	startMainThread(compiler->mainBlockFunc);
+}
+
+runtime::VM::VM(compileCore::CachedProgram& program) {
+	globals = program.globals;
+	bindNatives(globals);
+	sourceFiles = program.sourceFiles;
+	code = program.code;
+	startMainThread(program.mainBlockFunc);
+}
 
+// Defined here since WorkerPool is incomplete in vm.h
+runtime::VM::~VM() = default;
+
+void runtime::VM::startMainThread(object::ObjFunc* mainBlockFunc) {
+	Value val = Value(new object::ObjClosure(mainBlockFunc));
 	mainThread = new Thread(this);
 	// First value on the stack is the future holding the thread, mainThread has nil
 	mainThread->copyVal(Value::nil());
@@ -26,8 +42,14 @@ void runtime::VM::mark(memory::GarbageCollector* gc) {
 	for (Value& val : code.constants) val.mark();
 }
 
-void runtime::VM::execute() {
+int runtime::VM::execute() {
 	mainThread->executeBytecode();
+	return mainThread->getExitCode();
+}
+
+runtime::WorkerPool* runtime::VM::getWorkerPool() {
+	std::call_once(workerPoolFlag, [this] { workerPool = std::make_unique<WorkerPool>(this); });
+	return workerPool.get();
 }
 
 bool runtime::VM::allThreadsPaused() {
@@ -1,16 +1,23 @@
 #pragma once
-#include "../codegen/codegenDefs.h"
+#include "../Codegen/codegenDefs.h"
 #include "../Objects/objects.h"
 #include "thread.h"
+#include "../Codegen/bytecodeCache.h"
 #include <condition_variable>
+#include <memory>
 
 namespace runtime {
+	class WorkerPool;
+
 	string expectedType(string msg, Value val);
 
 	class VM {
 	public:
 		VM(compileCore::Compiler* compiler);
-		void execute();
+		VM(compileCore::CachedProgram& program);
+		~VM();
+		// Runs the program to completion, returns the exit code of the main thread
+		int execute();
 		void mark(memory::GarbageCollector* gc);
 		bool allThreadsPaused();
 		// Used by all threads
@@ -26,8 +33,16 @@ namespace runtime {
 		std::mutex pauseMtx;
 		std::condition_variable mainThreadCv;
 		std::condition_variable childThreadsCv;
-		std::atomic<byte> threadsPaused;
+		std::atomic<uInt> threadsPaused = 0;
 		Thread* mainThread;
+
+		// Workers for the parallel natives, started the first time one of them is called
+		WorkerPool* getWorkerPool();
+	private:
+		std::once_flag workerPoolFlag;
+		std::unique_ptr<WorkerPool> workerPool;
+
+		void startMainThread(object::ObjFunc* mainBlockFunc);
 	};
 
 }
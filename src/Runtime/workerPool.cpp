@@ -0,0 +1,147 @@
+#include "workerPool.h"
+#include "vm.h"
+#include <algorithm>
+
+using namespace runtime;
+
+ParallelJob::ParallelJob(Value _callee, uInt64 _count, uInt64 _chunkSize, object::ObjArray* _results, bool _passElements)
+	: next(0), active(0) {
+	callee = _callee;
+	count = _count;
+	chunkSize = std::max<uInt64>(_chunkSize, 1);
+	results = _results;
+	passElements = _passElements;
+	failed = false;
+	errorIndex = 0;
+}
+
+WorkerPool::WorkerPool(VM* _vm) {
+	vm = _vm;
+	job = nullptr;
+	stopping = false;
+	// The thread that calls run() works on the job too
+	uInt workerCount = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+	for (uInt i = 0; i < workerCount; i++) {
+		Thread* thread = new Thread(vm);
+		// Workers have no future, anything other than nil keeps them from being treated as the main thread
+		thread->copyVal(Value(true));
+		{
+			// Workers start out idle, which counts as paused, so they're registered as already paused
+			std::scoped_lock<std::mutex, std::mutex> lk(vm->pauseMtx, vm->mtx);
+			vm->childThreads.push_back(thread);
+			vm->threadsPaused.fetch_add(1);
+		}
+		threads.push_back(thread);
+		workers.emplace_back(&WorkerPool::workerLoop, this, thread);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		stopping = true;
+	}
+	cv.notify_all();
+	for (std::thread& worker : workers) worker.join();
+	std::scoped_lock<std::mutex, std::mutex> lk(vm->pauseMtx, vm->mtx);
+	for (Thread* thread : threads) {
+		std::erase(vm->childThreads, thread);
+		vm->threadsPaused.fetch_sub(1);
+		delete thread;
+	}
+}
+
+void WorkerPool::run(Thread* caller, ParallelJob& job) {
+	std::unique_lock<std::mutex> runLock(runMtx, std::try_to_lock);
+	if (!runLock.owns_lock() || workers.empty()) {
+		runChunks(caller, job);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		this->job = &job;
+	}
+	cv.notify_all();
+	runChunks(caller, job);
+	{
+		// No worker can pick up the job after this, so only those that already have it need to be waited for
+		std::lock_guard<std::mutex> lk(mtx);
+		this->job = nullptr;
+	}
+	waitForWorkers(caller, job);
+}
+
+void WorkerPool::workerLoop(Thread* thread) {
+	std::unique_lock<std::mutex> lk(mtx);
+	while (true) {
+		cv.wait(lk, [&] { return stopping || (job && job->next.load() < job->count); });
+		if (stopping) return;
+		ParallelJob* current = job;
+		current->active.fetch_add(1);
+		lk.unlock();
+
+		thread->leaveGCSafeRegion();
+		runChunks(thread, *current);
+		// Back to being idle before the caller can see that this worker is done
+		thread->enterGCSafeRegion();
+		{
+			std::lock_guard<std::mutex> pauseLock(vm->pauseMtx);
+			// Notified while holding the lock since the job is gone as soon as the caller sees active reach 0
+			if (current->active.fetch_sub(1) == 1) {
+				current->done.notify_all();
+				vm->mainThreadCv.notify_all();
+			}
+		}
+		lk.lock();
+	}
+}
+
+void WorkerPool::runChunks(Thread* thread, ParallelJob& job) {
+	uInt64 start;
+	while ((start = job.next.fetch_add(job.chunkSize)) < job.count) {
+		uInt64 end = std::min(start + job.chunkSize, job.count);
+		for (uInt64 i = start; i < end; i++) {
+			Value arg = job.passElements ? job.results->values[i] : Value(static_cast<double>(i));
+			Value result;
+			try {
+				result = thread->callFunction(job.callee, &arg, 1);
+			}
+			catch (int) {
+				std::lock_guard<std::mutex> lk(job.errorMtx);
+				if (!job.failed || i < job.errorIndex) {
+					job.failed = true;
+					job.errorIndex = i;
+					job.error = thread->getError();
+				}
+				// Nobody takes a new chunk after this
+				job.next.store(job.count);
+				return;
+			}
+			// Each index is written by exactly one thread, and the GC can't trace the array while this thread is running
+			if (job.results) job.results->values[i] = result;
+		}
+	}
+}
+
+void WorkerPool::waitForWorkers(Thread* caller, ParallelJob& job) {
+	if (!caller->isMainThread()) {
+		caller->enterGCSafeRegion();
+		{
+			std::unique_lock<std::mutex> lk(vm->pauseMtx);
+			job.done.wait(lk, [&] { return job.active.load() == 0; });
+		}
+		caller->leaveGCSafeRegion();
+		return;
+	}
+	std::unique_lock<std::mutex> lk(vm->pauseMtx);
+	// Workers still need collections to happen to make progress, so the main thread keeps running the GC while it waits
+	while (true) {
+		vm->mainThreadCv.wait(lk, [&] {
+			return job.active.load() == 0 || (memory::gc.shouldCollect.load() && vm->allThreadsPaused());
+		});
+		if (job.active.load() == 0) return;
+		lk.unlock();
+		memory::gc.collect(vm);
+		lk.lock();
+	}
+}
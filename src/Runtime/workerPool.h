@@ -0,0 +1,64 @@
+#pragma once
+#include "thread.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace runtime {
+	// Calls a CSL function for every index in [0, count), see WorkerPool::run
+	struct ParallelJob {
+		Value callee;
+		uInt64 count;
+		uInt64 chunkSize;
+		// If set the callee receives results->values[i] instead of i and the return value overwrites it
+		bool passElements;
+		// Return values are discarded if this is nullptr
+		object::ObjArray* results;
+
+		std::atomic<uInt64> next;
+		// Workers that picked up this job and haven't finished yet, guarded by VM::pauseMtx when it reaches 0
+		std::atomic<int> active;
+		std::condition_variable done;
+
+		// First error by index, later chunks are abandoned once a task fails
+		std::mutex errorMtx;
+		bool failed;
+		uInt64 errorIndex;
+		string error;
+
+		ParallelJob(Value _callee, uInt64 _count, uInt64 _chunkSize, object::ObjArray* _results, bool _passElements);
+	};
+
+	// Fixed set of threads that execute CSL functions for the parallel natives, created the first time it's needed
+	// Every worker runs on it's own runtime::Thread which is registered as a child thread of the VM, so the GC marks
+	// it's stack and waits for it like for any thread started with async. Idle workers count as paused
+	class WorkerPool {
+	public:
+		WorkerPool(VM* _vm);
+		~WorkerPool();
+
+		// Runs 'job' on the workers and the calling thread, returns once every task is done
+		// If the pool is already busy(a parallel native called from a task or from 2 threads at once) the job runs on the
+		// calling thread alone. Anything the job points to must be reachable from the caller's stack
+		void run(Thread* caller, ParallelJob& job);
+		uInt64 workerCount() { return workers.size(); }
+	private:
+		VM* vm;
+		vector<std::thread> workers;
+		vector<Thread*> threads;
+
+		// Guards 'job' and 'stopping'
+		std::mutex mtx;
+		std::condition_variable cv;
+		ParallelJob* job;
+		bool stopping;
+		// Held for the duration of a run
+		std::mutex runMtx;
+
+		void workerLoop(Thread* thread);
+		// Takes chunks of the job until there are none left
+		static void runChunks(Thread* thread, ParallelJob& job);
+		void waitForWorkers(Thread* caller, ParallelJob& job);
+	};
+}
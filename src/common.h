@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <cmath>
 #include <iostream>
+#include <string_view>
 
 using std::string;
 using std::vector;
@@ -15,12 +16,36 @@ typedef unsigned long long uInt64;
 typedef unsigned short uInt16;
 typedef unsigned char byte;
 
+// Hash map keyed by strings which can also be searched using a string_view, without allocating a string for the key
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+};
+template<typename T>
+using StringMap = unordered_map<string, T, StringHash, std::equal_to<>>;
+
 //Using epsilon value because of floating point precision
 #define DBL_EPSILON      2.2204460492503131e-016 // smallest such that 1.0+DBL_EPSILON != 1.0
 #define FLOAT_EQ(x,v) (fabs(x - v) <= DBL_EPSILON)
 #define IS_INT(num) (FLOAT_EQ(std::floor(num), num))
 
-#define AST_DEBUG
-#define COMPILER_DEBUG
 //#define COMPILER_USE_LONG_INSTRUCTION
-#define GC_PRINT_HEAP
+
+// Instruction sets the vectorized scanner and array kernels can be built on, from narrowest to widest
+enum class SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Debug output, off unless turned on from the command line
+namespace debugFlags {
+    // Prints the AST of every parsed module
+    inline bool printAST = false;
+    // Disassembles every compiled function
+    inline bool printBytecode = false;
+    // Prints the global variable array once compilation is done
+    inline bool printGlobals = false;
+    // Widest instruction set that may be used if the CPU supports it, lowered to benchmark the vector code against the scalar one
+    inline SimdLevel maxSimdLevel = SimdLevel::AVX2;
+}
@@ -0,0 +1,36 @@
+#include "cpuFeatures.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef CPU_X64
+static bool cpuSupportsAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    // The OS has to save the upper halves of ymm registers on context switches(OSXSAVE + AVX, then check XCR0)
+    bool osSupport = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+    __cpuidex(info, 7, 0);
+    return osSupport && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+SimdLevel selectSimdLevel() {
+    // Initialized once, thread safe
+    static const SimdLevel level = []() {
+#ifdef CPU_X64
+        if (debugFlags::maxSimdLevel == SimdLevel::SCALAR) return SimdLevel::SCALAR;
+        // SSE2 is part of x64, AVX2 has to be checked for
+        if (debugFlags::maxSimdLevel == SimdLevel::AVX2 && cpuSupportsAVX2()) return SimdLevel::AVX2;
+        return SimdLevel::SSE2;
+#else
+        return SimdLevel::SCALAR;
+#endif
+    }();
+    return level;
+}
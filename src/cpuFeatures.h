@@ -0,0 +1,19 @@
+#pragma once
+#include "common.h"
+
+// Vectorized code(the scanner and array kernels) is only compiled for x64, SSE2 is always available there,
+// AVX2 functions are marked with TARGET_AVX2 and only called if the CPU supports it
+#if defined(_M_X64) || defined(__x86_64__)
+#define CPU_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+// MSVC allows AVX2 intrinsics in any function
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Widest instruction set that the CPU supports and debugFlags::maxSimdLevel allows, always SCALAR on anything other than x64
+// Checked the first time it's called, the result is the same for the rest of the program
+SimdLevel selectSimdLevel();
@@ -1,21 +1,54 @@
-#include "common.h"
+#include "files.h"
+#include "ErrorHandling/errorHandler.h"
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <thread>
+#include <chrono>
 
-string readFile(char* path) {
-    std::filesystem::path p(path);
-    if (std::filesystem::exists(p)) {
-        std::stringstream ss;
-        std::ifstream file(path);
-        ss << file.rdbuf();
-        file.close();
-        return ss.str();
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+uInt64 hashSource(std::string_view source) {
+    uInt64 hash = 14695981039346656037ull;
+    for (char c : source) {
+        hash ^= static_cast<byte>(c);
+        hash *= 1099511628211ull;
     }
-    else {
-        std::cout << "Couldn't open file " << path << "\n";
+    return hash;
+}
+
+// Reads the whole file at once instead of going through a stringstream
+static bool tryReadFile(const char* path, string& contents) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::streampos size = file ? file.tellg() : std::streampos(-1);
+    if (size == std::streampos(-1)) return false;
+    contents.resize(static_cast<uInt64>(size));
+    file.seekg(0);
+    file.read(contents.data(), contents.size());
+    // The file might have been truncated since its size was read
+    contents.resize(file.gcount());
+    return !file.bad();
+}
+
+string readFile(char* path) {
+    string contents;
+    if (!tryReadFile(path, contents)) {
+        errorHandler::addSystemError("Couldn't read file " + string(path));
         return "";
     }
+    return contents;
 }
 
 string readFile(const char* path) {
@@ -24,4 +57,156 @@ string readFile(const char* path) {
 
 string readFile(string& path) {
     return readFile(path.c_str());
-}
\ No newline at end of file
+}
+
+MappedFile::MappedFile(const string& path, bool copy) {
+    data = nullptr;
+    size = 0;
+    isMapped = false;
+    valid = true;
+    if (copy) {
+        valid = tryReadFile(path.c_str(), fallback);
+        data = fallback.data();
+        size = fallback.size();
+        return;
+    }
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view) {
+            fileHandle = file;
+            mappingHandle = mapping;
+            data = static_cast<const char*>(view);
+            size = fileSize.QuadPart;
+            isMapped = true;
+            return;
+        }
+        if (mapping) CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd != -1 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            // The mapping stays valid after the descriptor is closed
+            close(fd);
+            data = static_cast<const char*>(view);
+            size = st.st_size;
+            isMapped = true;
+            return;
+        }
+    }
+    if (fd != -1) close(fd);
+#endif
+    // Empty files can't be mapped, anything else that failed is reported by the owner through isValid
+    valid = tryReadFile(path.c_str(), fallback);
+    data = fallback.data();
+    size = fallback.size();
+}
+
+MappedFile::~MappedFile() {
+    if (!isMapped) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+#else
+    munmap(const_cast<char*>(data), size);
+#endif
+}
+
+static bool isSourceFile(const std::filesystem::path& p) {
+    return p.extension() == ".csl";
+}
+
+// Hash of the names and modification times of every source file in the directory
+static uInt64 directorySnapshot(const string& directory) {
+    uInt64 hash = 14695981039346656037ull;
+    std::error_code ec;
+    for (auto& entry : std::filesystem::recursive_directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, ec)) {
+        if (!entry.is_regular_file(ec) || !isSourceFile(entry.path())) continue;
+        hash = (hash ^ std::hash<string>()(entry.path().string())) * 1099511628211ull;
+        hash = (hash ^ static_cast<uInt64>(entry.last_write_time(ec).time_since_epoch().count())) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Editors often save a file in several steps, events that arrive shortly after the first one are part of the same change
+#define WATCH_SETTLE_MS 50
+
+DirectoryWatcher::DirectoryWatcher(const string& _directory) {
+    directory = _directory;
+    snapshot = directorySnapshot(directory);
+#if defined(__linux__)
+    fd = inotify_init1(IN_CLOEXEC);
+    if (fd != -1) watchSubdirectories();
+#elif defined(_WIN32)
+    handle = FindFirstChangeNotificationA(directory.c_str(), TRUE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+#endif
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+#if defined(__linux__)
+    if (fd != -1) close(fd);
+#elif defined(_WIN32)
+    if (handle != INVALID_HANDLE_VALUE) FindCloseChangeNotification(handle);
+#endif
+}
+
+#ifdef __linux__
+// inotify isn't recursive, every subdirectory needs it's own watch, adding one to an already watched directory does nothing
+void DirectoryWatcher::watchSubdirectories() {
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+    inotify_add_watch(fd, directory.c_str(), mask);
+    std::error_code ec;
+    for (auto& entry : std::filesystem::recursive_directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, ec)) {
+        if (entry.is_directory(ec)) inotify_add_watch(fd, entry.path().c_str(), mask);
+    }
+}
+#endif
+
+void DirectoryWatcher::pollForChange() {
+    uInt64 current;
+    while ((current = directorySnapshot(directory)) == snapshot) std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    snapshot = current;
+}
+
+void DirectoryWatcher::wait() {
+#if defined(__linux__)
+    if (fd == -1) return pollForChange();
+    // Events that queued up since the last call are read first, so a save made during the previous run isn't missed
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+    bool newDirectory = false;
+    auto readEvents = [&]() {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        for (ssize_t i = 0; i < length;) {
+            inotify_event* event = reinterpret_cast<inotify_event*>(buffer + i);
+            // New directories may contain source files, they're picked up by the rebuild
+            if (event->mask & IN_ISDIR) newDirectory = true;
+            if ((event->mask & IN_ISDIR) || (event->len > 0 && isSourceFile(event->name))) changed = true;
+            i += sizeof(inotify_event) + event->len;
+        }
+        return length > 0;
+    };
+    while (!changed && readEvents()) {}
+    pollfd pfd = { fd, POLLIN, 0 };
+    while (poll(&pfd, 1, WATCH_SETTLE_MS) > 0 && readEvents()) {}
+    if (newDirectory) watchSubdirectories();
+#elif defined(_WIN32)
+    if (handle == INVALID_HANDLE_VALUE) return pollForChange();
+    // The handle stays signaled if something changed since the last call, so this returns right away
+    WaitForSingleObject(handle, INFINITE);
+    while (FindNextChangeNotification(handle) && WaitForSingleObject(handle, WATCH_SETTLE_MS) == WAIT_OBJECT_0) {}
+#else
+    pollForChange();
+#endif
+}
@@ -1,7 +1,66 @@
 #pragma once
 
 #include "common.h"
+#include <string_view>
 
+// Reports a system error and returns an empty string if the file can't be read
 string readFile(char* path);
 string readFile(const char* path);
 string readFile(string& path);
+
+// Watches for .csl files inside 'directory'(or any of it's subdirectories) being created, modified or removed
+// Changes are recorded from the moment the watcher is created, so ones made while nobody is waiting(eg. during a build)
+// aren't lost, they make the next call to wait return right away
+// Uses inotify on Linux and change notifications on Windows(which also wake up for other files), anywhere else
+// the directory is polled
+class DirectoryWatcher {
+public:
+    DirectoryWatcher(const string& _directory);
+    ~DirectoryWatcher();
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Blocks until something changed since the previous call returned(or since the watcher was created)
+    void wait();
+private:
+    string directory;
+    // Used if there is no way to get notified, or setting up notifications failed
+    uInt64 snapshot;
+#ifdef __linux__
+    int fd;
+    void watchSubdirectories();
+#elif defined(_WIN32)
+    void* handle;
+#endif
+    void pollForChange();
+};
+
+// FNV-1a hash of a file's contents, only used to detect changes to source files
+uInt64 hashSource(std::string_view source);
+
+// Read only view of a file mapped into memory, the view is valid for as long as the object is alive
+// If the file can't be mapped its contents are read into memory instead
+class MappedFile {
+public:
+    // Reading a mapping past the end of a file that was truncated in the meantime crashes the process, 'copy' reads
+    // the contents into memory instead for files that might be rewritten while the view is in use(eg. in watch mode)
+    MappedFile(const string& path, bool copy = false);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view getView() const { return std::string_view(data, size); }
+    // False if the file couldn't be read, the view is empty in that case
+    bool isValid() const { return valid; }
+private:
+    const char* data;
+    uInt64 size;
+    bool isMapped;
+    bool valid;
+    // Used if mapping failed
+    string fallback;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
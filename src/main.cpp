@@ -4,8 +4,13 @@
 #include "ErrorHandling/errorHandler.h"
 #include "Parsing/parser.h"
 #include "Codegen/compiler.h"
+#include "Codegen/bytecodeCache.h"
 #include "Runtime/vm.h"
-#include <chrono>
+#include "watchMode.h"
+#include "phaseStats.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
 static void windowsSetTerminalProcessing() {
@@ -17,28 +22,98 @@ static void windowsSetTerminalProcessing() {
     consoleMode |= ENABLE_PROCESSED_OUTPUT;
     SetConsoleMode(handleOut, consoleMode);
 };
+#endif
 
-int main() {
-    preprocessing::Preprocessor preprocessor;
-    preprocessor.preprocessProject("C:\\Temp\\main.csl");
-    vector<CSLModule*> modules = preprocessor.getSortedUnits();
-    AST::Parser parser;
-    parser.parse(modules);
+static int printUsage() {
+    std::cerr << "Usage: csl run <path/to/main.csl> [options]\n"
+                 "Options:\n"
+                 "  --watch           rebuild and rerun whenever a source file changes\n"
+                 "  --stats           print wall time and peak memory of every phase as JSON to stderr\n"
+                 "  --no-cache        ignore and don't write the bytecode cache\n"
+                 "  --print-ast       print the AST of every module\n"
+                 "  --print-bytecode  disassemble every compiled function\n"
+                 "  --print-globals   print the global variable array\n"
+                 "  --simd=<level>    widest instruction set used by the scanner and array natives:\n"
+                 "                    avx2(default, if the CPU supports it), sse2 or scalar\n";
+    return 64;
+}
 
+static bool reportErrors() {
+    if (!errorHandler::hasErrors()) return false;
+    errorHandler::showSystemErrors();
     errorHandler::showCompileErrors();
-    if (errorHandler::hasErrors()) exit(64);
+    return true;
+}
 
-    compileCore::Compiler compiler(modules);
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    windowsSetTerminalProcessing();
+#endif
+    if (argc < 3 || string(argv[1]) != "run") return printUsage();
+    string mainFilePath = std::filesystem::absolute(argv[2]).string();
+    bool watch = false, stats = false, useCache = true;
+    for (int i = 3; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--watch") watch = true;
+        else if (flag == "--stats") stats = true;
+        else if (flag == "--no-cache") useCache = false;
+        else if (flag == "--print-ast") debugFlags::printAST = true;
+        else if (flag == "--print-bytecode") debugFlags::printBytecode = true;
+        else if (flag == "--print-globals") debugFlags::printGlobals = true;
+        else if (flag == "--simd=avx2") debugFlags::maxSimdLevel = SimdLevel::AVX2;
+        else if (flag == "--simd=sse2") debugFlags::maxSimdLevel = SimdLevel::SSE2;
+        else if (flag == "--simd=scalar") debugFlags::maxSimdLevel = SimdLevel::SCALAR;
+        else {
+            std::cerr << "Unknown option '" << flag << "'.\n";
+            return printUsage();
+        }
+    }
+    // Printing happens in the front end, which a cache hit skips
+    if (debugFlags::printAST || debugFlags::printBytecode || debugFlags::printGlobals) useCache = false;
+    if (watch) {
+        watchProject(mainFilePath);
+        return 0;
+    }
 
-    errorHandler::showCompileErrors();
-    if (errorHandler::hasErrors()) exit(64);
+    PhaseStats phases;
+    runtime::VM* vm;
+    // If none of the source files changed since the last run, the front end is skipped entirely
+    compileCore::CachedProgram program;
+    phases.begin("loading cache");
+    if (useCache && compileCore::loadBytecodeCache(mainFilePath, program)) {
+        vm = new runtime::VM(program);
+    }
+    else {
+        // Errors the front end can't recover from are added as system errors and thrown as SystemException
+        try {
+            preprocessing::Preprocessor preprocessor;
+            preprocessor.preprocessProject(mainFilePath, &phases);
+            vector<CSLModule*> modules = preprocessor.getSortedUnits();
+            if (reportErrors()) exit(64);
+
+            phases.begin("parsing");
+            AST::Parser parser;
+            parser.parse(modules);
+            if (reportErrors()) exit(64);
+
+            phases.begin("compiling");
+            compileCore::Compiler compiler(modules);
+            if (reportErrors()) exit(64);
 
-    auto vm = new runtime::VM(&compiler);
+            preprocessor.commitImportGraph();
+            if (useCache) compileCore::writeBytecodeCache(mainFilePath, &compiler);
+            vm = new runtime::VM(&compiler);
+        }
+        catch (errorHandler::SystemException&) {
+            reportErrors();
+            exit(64);
+        }
+    }
 
-    auto t1 = std::chrono::high_resolution_clock::now();
-    vm->execute();
-    auto t2 = std::chrono::high_resolution_clock::now();
+    phases.begin("execution");
+    int exitCode = vm->execute();
+    phases.end();
 
-    std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms" << std::endl;
-    return 0;
+    if (stats) phases.printJson(std::cerr);
+    return exitCode;
 }
@@ -0,0 +1,96 @@
+#include "modulesDefs.h"
+#include "Parsing/ASTDefs.h"
+#include "ErrorHandling/errorHandler.h"
+#include <mutex>
+#include <array>
+
+namespace tokenArena {
+    File* files[UINT16_MAX + 1] = {};
+
+    namespace {
+        // Index 0 is never handed out, indices of files that were deleted are reused before new ones
+        uInt fileCount = 1;
+        vector<uInt16> freeFileIndices;
+        std::mutex filesMtx;
+
+        // Entries are stored in fixed size chunks which never move, so they can be read without taking the lock
+        // Chunks are kept when the pool is reset and reused by the next build
+        constexpr uInt CHUNK_SIZE = 4096;
+        constexpr uInt MAX_CHUNKS = 4096;
+        std::array<string, CHUNK_SIZE>* chunks[MAX_CHUNKS] = {};
+        uInt syntheticCount = 0;
+        std::mutex syntheticMtx;
+        // Synthetic strings are mostly the same few identifiers("this", "super"), so they're interned
+        unordered_map<string, uInt> internedText;
+
+        string& entry(uInt index) {
+            return (*chunks[index / CHUNK_SIZE])[index % CHUNK_SIZE];
+        }
+
+        // Has to be called while holding syntheticMtx
+        // Running out of entries can't be recovered from, the build is aborted with a SystemException
+        uInt allocate() {
+            if (syntheticCount / CHUNK_SIZE >= MAX_CHUNKS) {
+                errorHandler::addSystemError("Too many synthetic tokens.");
+                throw errorHandler::SystemException();
+            }
+            uInt index = syntheticCount++;
+            if (!chunks[index / CHUNK_SIZE]) chunks[index / CHUNK_SIZE] = new std::array<string, CHUNK_SIZE>();
+            return index;
+        }
+    }
+
+    uInt16 registerFile(File* file) {
+        std::scoped_lock<std::mutex> lk(filesMtx);
+        uInt index;
+        if (!freeFileIndices.empty()) {
+            index = freeFileIndices.back();
+            freeFileIndices.pop_back();
+        }
+        else {
+            if (fileCount > UINT16_MAX) {
+                errorHandler::addSystemError("Too many source files.");
+                throw errorHandler::SystemException();
+            }
+            index = fileCount++;
+        }
+        files[index] = file;
+        return index;
+    }
+
+    void unregisterFile(uInt16 index) {
+        std::scoped_lock<std::mutex> lk(filesMtx);
+        files[index] = nullptr;
+        freeFileIndices.push_back(index);
+    }
+
+    uInt addSynthetic(std::string_view text) {
+        std::scoped_lock<std::mutex> lk(syntheticMtx);
+        auto it = internedText.find(string(text));
+        if (it != internedText.end()) return it->second;
+        uInt index = allocate();
+        entry(index) = text;
+        internedText[string(text)] = index;
+        return index;
+    }
+
+    std::string_view getSyntheticText(uInt index) {
+        return entry(index);
+    }
+
+    void resetSynthetic() {
+        std::scoped_lock<std::mutex> lk(syntheticMtx);
+        syntheticCount = 0;
+        internedText.clear();
+    }
+}
+
+// Defined here since the arena is only a forward declaration in the header
+CSLModule::CSLModule(vector<Token> _tokens, File* _file) {
+    tokens = _tokens;
+    file = _file;
+    resolvedDeps = false;
+    traversed = false;
+}
+
+CSLModule::~CSLModule() = default;
@@ -1,8 +1,11 @@
 #pragma once
 #include "common.h"
+#include "files.h"
 #include <memory>
+#include <string_view>
+#include <cstdint>
 
-enum class TokenType {
+enum class TokenType : byte {
     // Single-character tokens.
     LEFT_PAREN, RIGHT_PAREN,
     LEFT_BRACE, RIGHT_BRACE,
@@ -36,14 +39,55 @@ enum class TokenType {
     NEWLINE, ERROR, NONE
 };
 
+struct File;
+struct Token;
+
+// Side tables for everything that doesn't fit into a Token
+// Adding entries is thread safe, reading an entry is safe on any thread that got the token referring to it
+namespace tokenArena {
+    // Index 0 is reserved for tokens that don't belong to any file
+    // Files register themselves when they're created and unregister when they're deleted, after which the index is reused
+    // Running out of file indices or synthetic entries adds a system error and throws errorHandler::SystemException
+    uInt16 registerFile(File* file);
+    void unregisterFile(uInt16 index);
+    extern File* files[UINT16_MAX + 1];
+    inline File* getFile(uInt16 index) { return files[index]; }
+
+    // Identical strings share the same entry
+    uInt addSynthetic(std::string_view text);
+    std::string_view getSyntheticText(uInt index);
+    // Invalidates every synthetic string token, only the compiler creates them so this is safe between builds
+    void resetSynthetic();
+}
+
 struct File {
     //file name
     string name;
-    string sourceFile;
+    //view of the contents of the file, backed either by a memory mapping or by 'ownedSource'
+    std::string_view sourceFile;
     //number that represents start of each line in the source string
     std::vector<uInt> lines;
-    File(string& src, string& _name) : sourceFile(src), name(_name) {};
+    //index of this file in tokenArena, tokens refer to their file through it
+    uInt16 index = 0;
+    //sources are mapped straight from disk, without copying
+    File(string& _name, std::unique_ptr<MappedFile> _mapping) : name(_name), mapping(std::move(_mapping)) {
+        sourceFile = mapping->getView();
+        index = tokenArena::registerFile(this);
+    };
+    File(string& src, string& _name) : name(_name), ownedSource(src) {
+        sourceFile = ownedSource;
+        index = tokenArena::registerFile(this);
+    };
     File() = default;
+    ~File() {
+        if (index != 0) tokenArena::unregisterFile(index);
+    }
+    //spans hold views into 'sourceFile', so a file can't be copied
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+private:
+    std::unique_ptr<MappedFile> mapping;
+    string ownedSource;
 };
 
 //span of characters in a source file of code
@@ -60,6 +104,11 @@ struct Span {
 
     // Get string corresponding to this Span
     [[nodiscard]] string getStr() const {
+        return string(getView());
+    }
+
+    // Same as getStr, but without copying the string out of the source file
+    [[nodiscard]] std::string_view getView() const {
         int start = sourceFile->lines[line] + column;
         return sourceFile->sourceFile.substr(start, length);
     }
@@ -70,63 +119,86 @@ struct Span {
         // If this Span is located on the last line of the file, then the line ends at the end of the file.
         int end = (line + 1 >= sourceFile->lines.size()) ? sourceFile->sourceFile.size() : sourceFile->lines[line + 1];
 
-        string line = sourceFile->sourceFile.substr(start, end - start);
+        string line = string(sourceFile->sourceFile.substr(start, end - start));
 
-        // Remove the '\n' at the end of the line.
-        if (line.back() == '\n') line.pop_back();
+        // Remove the '\n'(and '\r' of files with windows line endings) at the end of the line.
+        if (!line.empty() && line.back() == '\n') line.pop_back();
+        if (!line.empty() && line.back() == '\r') line.pop_back();
 
         return line;
     }
 };
 
+// 16 bytes and trivially copyable, anything larger(synthetic text) lives in tokenArena
 struct Token {
+    //offset of the lexeme in the source file, or the index of the entry in tokenArena for synthetic tokens
+    uInt start;
+    uInt length;
+    uInt line;
+    uInt16 fileIndex;
     TokenType type;
-    Span str;
-
     //for things like synthetic tokens and expanded macros
     bool isSynthetic;
-    string syntheticStr;
-    std::shared_ptr<Token> parentPtr; // Pointer to the token this token originated from
+
     //default constructor
     Token() {
-        isSynthetic = false;
-        parentPtr = nullptr;
+        start = 0;
+        length = 0;
+        line = 0;
+        fileIndex = 0;
         type = TokenType::NONE;
+        isSynthetic = false;
     }
     //construct a token from source file string data
-    Token(Span _str, TokenType _type) {
-        isSynthetic = false;
-        parentPtr = nullptr;
-        str = _str;
+    Token(Span str, TokenType _type) {
+        start = str.sourceFile->lines[str.line] + str.column;
+        length = str.length;
+        line = str.line;
+        fileIndex = str.sourceFile->index;
         type = _type;
+        isSynthetic = false;
     }
     //construct a token which doesn't appear in the source file(eg. splitting a += b into a = a + b, where '+' is synthetic)
-    Token(TokenType _type, Token parentToken) {
-        parentPtr = std::make_shared<Token>(parentToken);
-        isSynthetic = true;
+    //it takes the position(and lexeme) of the token it originated from, so it's only valid for as long as that one is
+    Token(TokenType _type, const Token& parentToken) {
+        *this = parentToken;
         type = _type;
     }
-    Token(TokenType _type, string str) {
-        isSynthetic = true;
-        parentPtr = nullptr;
+    Token(TokenType _type, std::string_view str) {
+        start = tokenArena::addSynthetic(str);
+        length = str.size();
+        line = 0;
+        fileIndex = 0;
         type = _type;
-        syntheticStr = str;
+        isSynthetic = true;
     }
     string getLexeme() const {
+        return string(getLexemeView());
+    }
+    //view into the source file(or the synthetic text), valid for as long as the file is alive
+    std::string_view getLexemeView() const {
         if (type == TokenType::ERROR) { return "Unexpected character."; }
-        else if (isSynthetic) { return syntheticStr; }
-        return str.getStr();
+        else if (isSynthetic) { return tokenArena::getSyntheticText(start); }
+        return tokenArena::getFile(fileIndex)->sourceFile.substr(start, length);
+    }
+    //position of the token in it's source file, synthetic strings don't have one
+    Span getSpan() const {
+        if (isSynthetic) return Span();
+        File* file = tokenArena::getFile(fileIndex);
+        return Span(line, start - file->lines[line], length, file);
     }
 
-    bool compare(Token token) {
-        return getLexeme().compare(token.getLexeme()) == 0 && type == token.type;
+    bool compare(const Token& token) const {
+        return type == token.type && getLexemeView() == token.getLexemeView();
     }
 };
+static_assert(sizeof(Token) == 16, "Token should stay small enough to be passed around by value");
 
 struct CSLModule;
 
 namespace AST {
     class ASTNode;
+    class ASTArena;
 }
 
 struct Dependency {
@@ -147,17 +219,15 @@ struct CSLModule {
     //used for toposort once we have resolved all dependencies
     bool traversed;
 
-    //AST of this file
-    vector<std::shared_ptr<AST::ASTNode>> stmts;
+    //AST of this file, every node is allocated in 'astArena' and freed together with the module
+    vector<AST::ASTNode*> stmts;
+    std::unique_ptr<AST::ASTArena> astArena;
     //exported declarations
     vector<Token> exports;
     //used by the compiler to look up if a global variable exists since globals are late bound
     vector<Token> topDeclarations;
 
-    CSLModule(vector<Token> _tokens, File* _file) {
-        tokens = _tokens;
-        file = _file;
-        resolvedDeps = false;
-        traversed = false;
-    };
+    CSLModule(vector<Token> _tokens, File* _file);
+    CSLModule(const CSLModule&) = delete;
+    ~CSLModule();
 };
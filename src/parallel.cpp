@@ -0,0 +1,32 @@
+#include "parallel.h"
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+void parallelFor(uInt count, const std::function<void(uInt)>& task) {
+    uInt threadCount = std::min<uInt>(std::max(std::thread::hardware_concurrency(), 1u), count);
+    std::atomic<uInt> next = 0;
+    vector<std::exception_ptr> exceptions(count);
+
+    auto worker = [&]() {
+        uInt i;
+        while ((i = next++) < count) {
+            try {
+                task(i);
+            }
+            catch (...) {
+                exceptions[i] = std::current_exception();
+            }
+        }
+    };
+    // The calling thread does work too instead of just waiting
+    vector<std::thread> threads;
+    for (uInt i = 1; i < threadCount; i++) threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads) t.join();
+
+    for (std::exception_ptr& e : exceptions) {
+        if (e) std::rethrow_exception(e);
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "common.h"
+#include <functional>
+
+// Runs task(i) for every i in [0, count) on up to hardware_concurrency threads and returns once every task is done.
+// Tasks are handed out one at a time, so uneven task sizes balance out between threads.
+// If any task throws, the exception of the task with the lowest index is rethrown on the calling thread.
+void parallelFor(uInt count, const std::function<void(uInt)>& task);
@@ -0,0 +1,65 @@
+#include "phaseStats.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+void PhaseStats::begin(string phase) {
+    end();
+    current = phase;
+    currentBytes = 0;
+    start = std::chrono::steady_clock::now();
+}
+
+void PhaseStats::end() {
+    if (current.empty()) return;
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    phases.push_back({ current, elapsed.count(), peakRssKB(), currentBytes });
+    current.clear();
+}
+
+void PhaseStats::addBytes(uInt64 bytes) {
+    currentBytes += bytes;
+}
+
+void PhaseStats::printJson(std::ostream& out) {
+    end();
+    double total = 0;
+    out << "{\"phases\":[";
+    for (uInt i = 0; i < phases.size(); i++) {
+        // Phase names are fixed identifiers, they never need escaping
+        out << (i == 0 ? "" : ",") << "{\"name\":\"" << phases[i].name << "\",\"ms\":" << phases[i].ms
+            << ",\"peakRssKB\":" << phases[i].peakRssKB;
+        if (phases[i].bytes != 0) {
+            double mbps = phases[i].ms > 0 ? (phases[i].bytes / (1024.0 * 1024.0)) / (phases[i].ms / 1000.0) : 0;
+            out << ",\"bytes\":" << phases[i].bytes << ",\"MBps\":" << mbps;
+        }
+        out << "}";
+        total += phases[i].ms;
+    }
+    out << "],\"totalMs\":" << total << ",\"peakRssKB\":" << peakRssKB() << "}\n";
+}
+
+uInt64 peakRssKB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    // macOS reports bytes, Linux reports kilobytes
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
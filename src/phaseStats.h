@@ -0,0 +1,32 @@
+#pragma once
+
+#include "common.h"
+#include <chrono>
+
+// Wall time and peak resident memory of every phase of a run, reported with --stats
+class PhaseStats {
+public:
+    // Ends the current phase(if any) and starts timing 'phase'
+    void begin(string phase);
+    void end();
+    // Bytes of input handled by the current phase, phases that report it also get their throughput printed
+    void addBytes(uInt64 bytes);
+    // Single JSON object: {"phases":[{"name":...,"ms":...,"peakRssKB":...[,"bytes":...,"MBps":...]},...],
+    // "totalMs":...,"peakRssKB":...}
+    void printJson(std::ostream& out);
+private:
+    struct Phase {
+        string name;
+        double ms;
+        // Peak RSS of the whole process once the phase ended, it never decreases
+        uInt64 peakRssKB;
+        uInt64 bytes;
+    };
+    vector<Phase> phases;
+    string current;
+    uInt64 currentBytes = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Peak resident set size of the process so far, in kilobytes, 0 if the platform doesn't report it
+uInt64 peakRssKB();
@@ -0,0 +1,66 @@
+#include "watchMode.h"
+#include "files.h"
+#include "Preprocessing/preprocessor.h"
+#include "ErrorHandling/errorHandler.h"
+#include "Parsing/parser.h"
+#include "Codegen/compiler.h"
+#include "Runtime/vm.h"
+#include <filesystem>
+#include <chrono>
+#include <memory>
+
+void watchProject(string mainFilePath) {
+    string projectRoot = std::filesystem::path(mainFilePath).parent_path().string();
+    preprocessing::Preprocessor preprocessor(true);
+    // Created before the first build, so that saves made while building or running aren't missed
+    DirectoryWatcher watcher(projectRoot);
+    // Set until a build succeeds, afterwards builds are skipped if none of the project's modules changed
+    bool needsBuild = true;
+
+    while (true) {
+        errorHandler::clearErrors();
+        // Nothing from the previous build's compiler is alive anymore
+        tokenArena::resetSynthetic();
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::unique_ptr<compileCore::Compiler> compiler;
+        try {
+            preprocessor.preprocessProject(mainFilePath);
+            // Files that aren't imported by the project changed, or a file was saved without any changes
+            if (!needsBuild && !errorHandler::hasErrors() && preprocessor.getDirtyUnits().empty()) {
+                watcher.wait();
+                continue;
+            }
+
+            vector<CSLModule*> modules = preprocessor.getSortedUnits();
+            if (!errorHandler::hasErrors()) {
+                AST::Parser parser;
+                parser.parse(modules);
+            }
+            if (!errorHandler::hasErrors()) compiler = std::make_unique<compileCore::Compiler>(modules, true);
+        }
+        catch (errorHandler::SystemException&) {
+            // The system error was already added, it's reported below and the next build starts from scratch
+        }
+
+        if (errorHandler::hasErrors()) {
+            errorHandler::showSystemErrors();
+            errorHandler::showCompileErrors();
+            errorHandler::clearErrors();
+            // Modules that failed to parse can't be reused, so the next build starts from scratch
+            preprocessor.releaseUnits();
+            needsBuild = true;
+        }
+        else {
+            preprocessor.commitImportGraph();
+            needsBuild = false;
+            auto t2 = std::chrono::high_resolution_clock::now();
+            std::cout << "Built in " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms" << std::endl;
+
+            runtime::VM vm(compiler.get());
+            vm.execute();
+        }
+        // Output is only flushed automatically when the buffer fills up, and the program's output should show up before waiting
+        std::cout << "Watching for changes..." << std::endl;
+        watcher.wait();
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "common.h"
+
+// Builds and runs the project, then rebuilds and reruns it every time one of it's source files changes. Never returns.
+// Modules whose files didn't change keep their tokens and AST between builds, so only changed files are rescanned and
+// reparsed. Code generation always runs over the whole project since the globals of all modules share one array.
+void watchProject(string mainFilePath);